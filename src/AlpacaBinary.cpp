@@ -0,0 +1,95 @@
+#include "AlpacaBinary.h"
+#include "AlpacaDevice.h"
+
+// same lookup and connection check as the http binding handler, errors are alpaca error numbers
+int32_t AlpacaBinary::_read(AlpacaDevice *const *devices, int n_devices, uint8_t device, const char *name, AlpacaReading &reading) {
+    if (device >= n_devices)
+        return AlpacaInvalidValueException;
+    const AlpacaBinding *binding = devices[device]->findBinding(name);
+    if (binding == nullptr || binding->read == nullptr)
+        return AlpacaNotImplementedException;
+    // no client session over udp, the device is connected while any client has it connected
+    if (binding->connected && !devices[device]->getAlpacaServer()->isConnected(nullptr, devices[device]))
+        return AlpacaNotConnectedException;
+    // handlers respond() with AscomErrorCode values
+    int32_t error = alpacaErrorNumber(binding->read(*devices[device], reading));
+    if (error)
+        reading.type = AlpacaNone;
+    return error;
+}
+
+// answer all reads of a request, returns the response length or 0 to drop a malformed packet
+size_t AlpacaBinary::handle(AlpacaDevice *const *devices, int n_devices, const uint8_t *request, size_t len) {
+    uint32_t start = micros();
+    if (len < ALPACA_BINARY_HEADER || request[0] != 'A' || request[1] != 'B' || request[2] != ALPACA_BINARY_VERSION || request[3] > ALPACA_BINARY_MAX_READS) {
+        _malformed++;
+        return 0;
+    }
+    uint8_t count = request[3];
+    memcpy(_response, request, ALPACA_BINARY_HEADER);
+    size_t in = ALPACA_BINARY_HEADER;
+    size_t out = ALPACA_BINARY_HEADER;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (in + 2 > len || in + 2 + request[in + 1] > len) {
+            _malformed++;
+            return 0;
+        }
+        uint8_t device = request[in];
+        uint8_t name_len = request[in + 1];
+        char name[ALPACA_BINARY_MAX_NAME + 1] = "";
+        if (name_len <= ALPACA_BINARY_MAX_NAME) {
+            memcpy(name, request + in + 2, name_len);
+            name[name_len] = '\0';
+        }
+        in += 2 + name_len;
+
+        AlpacaReading reading = {AlpacaNone, {false}};
+        int32_t error = _read(devices, n_devices, device, name, reading);
+        size_t value_len = 0;
+        uint8_t string_len = 0;
+        if (reading.type == AlpacaBool)
+            value_len = 1;
+        else if (reading.type == AlpacaInt || reading.type == AlpacaFloat)
+            value_len = 4;
+        else if (reading.type == AlpacaString) {
+            string_len = min(strlen(reading.s), (size_t)UINT8_MAX);
+            value_len = 1 + string_len;
+        }
+        // the reply is a single datagram, reads that don't fit fail
+        if (out + 5 + value_len > sizeof(_response)) {
+            error = AlpacaInvalidOperationException;
+            reading.type = AlpacaNone;
+            value_len = 0;
+        }
+
+        memcpy(_response + out, &error, 4);
+        _response[out + 4] = reading.type;
+        out += 5;
+        if (reading.type == AlpacaBool)
+            _response[out] = reading.b;
+        else if (reading.type == AlpacaInt)
+            memcpy(_response + out, &reading.i, 4);
+        else if (reading.type == AlpacaFloat)
+            memcpy(_response + out, &reading.f, 4);
+        else if (reading.type == AlpacaString) {
+            _response[out] = string_len;
+            memcpy(_response + out + 1, reading.s, string_len);
+        }
+        out += value_len;
+        _reads++;
+        if (error)
+            _errors++;
+    }
+    _packets++;
+    _busyUs += micros() - start;
+    return out;
+}
+
+void AlpacaBinary::writeStats(JsonObject root) {
+    root[F("Packets")] = _packets;
+    root[F("Reads")] = _reads;
+    root[F("Errors")] = _errors;
+    root[F("Malformed")] = _malformed;
+    root[F("MeanUs")] = _packets ? _busyUs / _packets : 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "AlpacaHelpers.h"
+#include "AlpacaBinding.h"
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_BINARY_PORT
+#define ALPACA_BINARY_PORT 32228
+#endif
+#ifndef ALPACA_BINARY_MAX_READS
+#define ALPACA_BINARY_MAX_READS 16
+#endif
+#define ALPACA_BINARY_MAX_PACKET 1472 // one datagram without ip fragmentation
+#define ALPACA_BINARY_VERSION 1
+#define ALPACA_BINARY_HEADER 8
+#define ALPACA_BINARY_MAX_NAME 32
+#define ALPACA_BINARY_MAX_STRING 256 // string values are sent with a u8 length
+
+// Compact request/response protocol for local pollers, one UDP datagram each way, little endian.
+//   request:  'A' 'B' version count transaction_id:u32, count x {device:u8 len:u8 name[len]}
+//   response: same header echoed, count x {error:i32 type:u8 value}
+// error is 0 or an alpaca error number (AlpacaErrorCode, 0x500 - 0xFFF for driver errors), also when the
+// handler responded with the matching AscomErrorCode.
+// device is the index in /management/v1/configureddevices, name the property as in the url.
+// value is bool:u8, int:i32, float:f32 or string len:u8 + bytes, depending on AlpacaReadingType,
+// and empty for errors. Typed ALPACA_GET getters can be read, raw handlers only when bound with
+// ALPACA_RAW_BINARY. Those are called with a null request on the udp task and must only respond() to it.
+class AlpacaBinary {
+  private:
+    uint8_t _response[ALPACA_BINARY_MAX_PACKET]; // one packet at a time on the udp task
+    // statistics
+    uint32_t _packets = 0;
+    uint32_t _reads = 0;
+    uint32_t _errors = 0;
+    uint32_t _malformed = 0;
+    uint32_t _busyUs = 0;
+
+    int32_t _read(AlpacaDevice *const *devices, int n_devices, uint8_t device, const char *name, AlpacaReading &reading);
+
+  public:
+    size_t handle(AlpacaDevice *const *devices, int n_devices, const uint8_t *request, size_t len);
+    const uint8_t *response() { return _response; }
+    void writeStats(JsonObject root);
+};
@@ -0,0 +1,48 @@
+#include "AlpacaBinding.h"
+#include "AlpacaDevice.h"
+
+bool AlpacaBindingHandler::add(const AlpacaBinding *table, size_t size) {
+    if (_n_tables == ALPACA_MAX_BINDINGS)
+        return false;
+    _table[_n_tables] = table;
+    _size[_n_tables++] = size;
+    return true;
+}
+
+// tables bound last win, so a driver can override commands of its base class
+const AlpacaBinding *AlpacaBindingHandler::find(const char *command, WebRequestMethodComposite method) const {
+    for (int t = _n_tables - 1; t >= 0; t--) {
+        for (size_t i = 0; i < _size[t]; i++) {
+            const AlpacaBinding &binding = _table[t][i];
+            if ((binding.method & method) && strcasecmp(command, binding.command) == 0)
+                return &binding;
+        }
+    }
+    return nullptr;
+}
+
+const AlpacaBinding *AlpacaBindingHandler::_find(AsyncWebServerRequest *request) const {
+    const String &url = request->url();
+    if (!url.startsWith(_prefix))
+        return nullptr;
+    return find(url.c_str() + _prefix.length(), request->method());
+}
+
+bool AlpacaBindingHandler::canHandle(AsyncWebServerRequest *request) const {
+    return _find(request) != nullptr;
+}
+
+void AlpacaBindingHandler::handleRequest(AsyncWebServerRequest *request) {
+    const AlpacaBinding *binding = _find(request);
+    if (binding == nullptr)
+        return;
+    AlpacaServer *server = _device->getAlpacaServer();
+    uint32_t start = server->requestBegin(request);
+    if (binding->fn == nullptr)
+        server->respond(request, nullptr, NotImplemented);
+    else if (binding->connected && !server->isConnected(request, _device))
+        server->respond(request, nullptr, NotConnected, "Not connected");
+    else
+        binding->fn(*_device, request, binding->param);
+    server->requestEnd(request, start);
+}
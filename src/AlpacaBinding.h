@@ -0,0 +1,183 @@
+#pragma once
+#include <type_traits>
+#include <ESPAsyncWebServer.h>
+#include "AlpacaHelpers.h"
+
+#define ALPACA_MAX_BINDINGS 4
+
+// Forward declare AlpacaDevice to avoid circular includes
+class AlpacaDevice;
+
+// handler generated for one binding, param is the PUT parameter name
+typedef void (*AlpacaBindingFn)(AlpacaDevice &device, AsyncWebServerRequest *request, const char *param);
+
+// value of a typed getter, read without a web request by the binary protocol
+enum AlpacaReadingType : uint8_t {
+    AlpacaNone = 0,
+    AlpacaBool = 1,
+    AlpacaInt = 2,
+    AlpacaFloat = 3,
+    AlpacaString = 4
+};
+typedef struct {
+    AlpacaReadingType type;
+    union {
+        bool b;
+        int32_t i;
+        float f;
+        const char *s;
+    };
+} AlpacaReading;
+// returns 0 or the error number of the read
+typedef int32_t (*AlpacaReadFn)(AlpacaDevice &device, AlpacaReading &reading);
+
+// true when the device class overrides a default handler
+typedef bool (*AlpacaOverriddenFn)(AlpacaDevice &device);
+
+// one alpaca command, static tables of these are built with the macros below
+typedef struct {
+    const char *command;
+    WebRequestMethodComposite method;
+    const char *param;
+    bool connected;     // answer NotConnected while the device is disconnected
+    AlpacaBindingFn fn; // nullptr answers NotImplemented
+    AlpacaReadFn read;  // GET commands only
+    AlpacaOverriddenFn overridden; // default handlers only, listed in supportedactions once overridden
+} AlpacaBinding;
+
+// Dispatches all bound commands of one device from a single web handler,
+// instead of one AsyncCallbackWebHandler and std::function per endpoint.
+class AlpacaBindingHandler : public AsyncWebHandler {
+  private:
+    AlpacaDevice *_device;
+    String _prefix;
+    const AlpacaBinding *_table[ALPACA_MAX_BINDINGS];
+    size_t _size[ALPACA_MAX_BINDINGS];
+    int _n_tables = 0;
+
+    const AlpacaBinding *_find(AsyncWebServerRequest *request) const;
+
+  public:
+    AlpacaBindingHandler(AlpacaDevice *device, const String &prefix) : _device(device), _prefix(prefix) {}
+    bool add(const AlpacaBinding *table, size_t size);
+    const AlpacaBinding *find(const char *command, WebRequestMethodComposite method) const;
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+    // alpaca PUT parameters come form encoded in the body, only parsed for non trivial handlers
+    bool isRequestHandlerTrivial() const override { return false; }
+};
+
+// respond() and getParam() overloads for the bound value types
+template <typename T>
+struct AlpacaValue {
+    typedef typename std::conditional<std::is_same<T, bool>::value, bool,
+                                      typename std::conditional<std::is_integral<T>::value, int, float>::type>::type param;
+};
+
+template <typename T>
+typename std::enable_if<std::is_same<T, bool>::value, bool>::type alpacaValue(T value) { return value; }
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int32_t>::type alpacaValue(T value) { return value; }
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, float>::type alpacaValue(T value) { return value; }
+inline const char *alpacaValue(const char *value) { return value; }
+
+// value types of bound getters and setters
+template <typename M>
+struct AlpacaGetter;
+template <typename D, typename T>
+struct AlpacaGetter<T (D::*)()> {
+    typedef T type;
+};
+inline void alpacaRead(AlpacaReading &reading, bool value) {
+    reading.type = AlpacaBool;
+    reading.b = value;
+}
+inline void alpacaRead(AlpacaReading &reading, int32_t value) {
+    reading.type = AlpacaInt;
+    reading.i = value;
+}
+inline void alpacaRead(AlpacaReading &reading, float value) {
+    reading.type = AlpacaFloat;
+    reading.f = value;
+}
+inline void alpacaRead(AlpacaReading &reading, const char *value) {
+    reading.type = AlpacaString;
+    reading.s = value;
+}
+
+template <typename M>
+struct AlpacaSetter;
+template <typename D, typename T>
+struct AlpacaSetter<int32_t (D::*)(T)> {
+    typedef T type;
+};
+
+// call an aGet*/aPut* request handler of the device class
+template <typename D, void (D::*Method)(AsyncWebServerRequest *)>
+void alpacaBindRaw(AlpacaDevice &device, AsyncWebServerRequest *request, const char *) {
+    (static_cast<D &>(device).*Method)(request);
+}
+
+// same handler for the binary protocol, called with a null request on the udp task so the server captures
+// its respond(), only for entries that opt in with ALPACA_RAW_BINARY
+template <typename D, void (D::*Method)(AsyncWebServerRequest *)>
+int32_t alpacaReadRaw(AlpacaDevice &device, AlpacaReading &reading) {
+    D &d = static_cast<D &>(device);
+    d.getAlpacaServer()->captureBegin(reading);
+    (d.*Method)(nullptr);
+    return d.getAlpacaServer()->captureEnd();
+}
+
+// respond with the value of a typed getter
+template <typename D, typename T, T (D::*Get)()>
+void alpacaBindGet(AlpacaDevice &device, AsyncWebServerRequest *request, const char *) {
+    D &d = static_cast<D &>(device);
+    d.getAlpacaServer()->respond(request, alpacaValue((d.*Get)()));
+}
+
+// same getter for the binary protocol
+template <typename D, typename T, T (D::*Get)()>
+int32_t alpacaReadGet(AlpacaDevice &device, AlpacaReading &reading) {
+    D &d = static_cast<D &>(device);
+    alpacaRead(reading, alpacaValue((d.*Get)()));
+    return 0;
+}
+
+// parse the parameter and pass it to a typed setter, which returns 0 or an error number
+template <typename D, typename T, int32_t (D::*Set)(T)>
+void alpacaBindPut(AlpacaDevice &device, AsyncWebServerRequest *request, const char *param) {
+    static_assert(std::is_arithmetic<T>::value, "bound setters take bool, integer or float");
+    D &d = static_cast<D &>(device);
+    typename AlpacaValue<T>::param value;
+    if (!d.getAlpacaServer()->getParam(request, param, value)) {
+        d.getAlpacaServer()->respond(request, nullptr, InvalidValue, "Missing parameter");
+        return;
+    }
+    d.getAlpacaServer()->respond(request, nullptr, (d.*Set)((T)value));
+}
+
+// table entries, D is the class the table is defined in
+#define ALPACA_RAW(D, command, method, fn) {command, method, nullptr, false, &alpacaBindRaw<D, &D::fn>, nullptr, nullptr}
+// raw GET entry that the binary protocol may read too, for handlers that only pass their request to respond()
+#define ALPACA_RAW_BINARY(D, command, fn) \
+    {command, HTTP_GET, nullptr, false, &alpacaBindRaw<D, &D::fn>, &alpacaReadRaw<D, &D::fn>, nullptr}
+// entry for an overridable default handler, listed in supportedactions only when a subclass overrides it.
+// Compares the vtable entry of the device with D::fn using the gcc bound member function extension,
+// the warning fires where the member pointer is written so it is suppressed here.
+#define ALPACA_DEFAULT(D, command, method, fn)                                                             \
+    {command, method, nullptr, false, &alpacaBindRaw<D, &D::fn>, nullptr, [](AlpacaDevice &device) -> bool { \
+         typedef void (*Fn)(D *, AsyncWebServerRequest *);                                                  \
+         D &d = static_cast<D &>(device);                                                                   \
+         _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wpmf-conversions\"")             \
+         return (Fn)(d.*&D::fn) != (Fn)(&D::fn);                                                            \
+         _Pragma("GCC diagnostic pop")                                                                      \
+     }}
+#define ALPACA_GET(D, command, getter) ALPACA_GET_BINDING(D, command, getter, true)
+#define ALPACA_GET_UNCONNECTED(D, command, getter) ALPACA_GET_BINDING(D, command, getter, false)
+#define ALPACA_GET_BINDING(D, command, getter, connected)                                      \
+    {command, HTTP_GET, nullptr, connected,                                                    \
+     &alpacaBindGet<D, AlpacaGetter<decltype(&D::getter)>::type, &D::getter>,                  \
+     &alpacaReadGet<D, AlpacaGetter<decltype(&D::getter)>::type, &D::getter>, nullptr}
+#define ALPACA_PUT(D, command, param, setter) {command, HTTP_PUT, param, true, &alpacaBindPut<D, AlpacaSetter<decltype(&D::setter)>::type, &D::setter>, nullptr, nullptr}
+#define ALPACA_NOT_IMPLEMENTED(command, method) {command, method, nullptr, false, nullptr, nullptr, nullptr}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// bus backend, write tx and then read rx from the device at address, either may be empty
+class AlpacaBus {
+  public:
+    virtual ~AlpacaBus() {}
+    virtual bool transfer(uint8_t address, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) = 0;
+};
@@ -1,67 +1,115 @@
 #include "AlpacaDevice.h"
 
+AlpacaDevice::AlpacaDevice() : _config([](AlpacaDeviceConfig &config) { strcpy(config.desc, "Alpaca ESP32 driver"); }) {}
+
 // create url and register callback for REST API
 void AlpacaDevice::createCallBack(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char command[], bool devicemethod) {
     char url[64];
     snprintf(url, sizeof(url), ALPACA_DEVICE_COMMAND, _device_type, _device_number, command);
-    _alpacaServer->logMessage("[ALPACA] Register handler for \"" + String(url) + "\" to " + String(command));
+    if (_alpacaServer->logEnabled())
+        _alpacaServer->logMessage("[ALPACA] Register handler for \"" + String(url) + "\" to " + String(command));
 
     // register handler for generated URI
-    _alpacaServer->getServerTCP()->on(url, type, fn);
+    _alpacaServer->on(url, type, fn);
 
     // add command to supported methods if devicemethod is true
-    if (devicemethod) {
-        int len = strlen(_supported_actions);
-        _supported_actions[len - 1] = '\0';
-        if (len > 2)
-            strcat(_supported_actions, ", \"");
-        else
-            strcat(_supported_actions, "\"");
-        strcat(_supported_actions, command);
-        strcat(_supported_actions, "\"]");
+    if (devicemethod)
+        _addSupportedAction(command);
+}
+
+// bind a table of commands, all tables of a device share one web handler
+void AlpacaDevice::bind(const AlpacaBinding *table, size_t size, bool devicemethods) {
+    if (_bindings == nullptr) {
+        char prefix[64];
+        snprintf(prefix, sizeof(prefix), ALPACA_DEVICE_COMMAND, _device_type, _device_number, "");
+        _bindings = new AlpacaBindingHandler(this, prefix);
+        _alpacaServer->getServerTCP()->addHandler(_bindings);
+    }
+    if (!_bindings->add(table, size)) {
+        _alpacaServer->logMessage("[ALPACA] Too many binding tables for " + String(_device_type));
+        return;
     }
+    if (_alpacaServer->logEnabled())
+        _alpacaServer->logMessage("[ALPACA] Bind " + String(size) + " commands for " + String(_device_type) + " " + String(_device_number));
+
+    // implemented commands only, GET and PUT of a property are listed once
+    if (devicemethods) {
+        for (size_t i = 0; i < size; i++) {
+            if (table[i].fn != nullptr && (table[i].overridden == nullptr || table[i].overridden(*this)))
+                _addSupportedAction(table[i].command);
+        }
+    }
+}
+
+void AlpacaDevice::setDeviceName(const char *name) {
+    _config.update([name](AlpacaDeviceConfig &config) { strlcpy(config.name, name, sizeof(config.name)); });
+}
+
+void AlpacaDevice::setDeviceDescription(const char *desc) {
+    _config.update([desc](AlpacaDeviceConfig &config) { strlcpy(config.desc, desc, sizeof(config.desc)); });
+}
+
+void AlpacaDevice::_addSupportedAction(const char *command) {
+    char quoted[40];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", command);
+    int len = strlen(_supported_actions);
+    if (strstr(_supported_actions, quoted) || len + strlen(quoted) + 2 >= sizeof(_supported_actions))
+        return;
+    _supported_actions[len - 1] = '\0';
+    if (len > 2)
+        strcat(_supported_actions, ", ");
+    strcat(_supported_actions, quoted);
+    strcat(_supported_actions, "]");
 }
 
 void AlpacaDevice::_setSetupPage() {
     char url[64];
     snprintf(url, sizeof(url), ALPACA_DEVICE_COMMAND, _device_type, _device_number, "jsondata");
     // setup json get handler
-    this->createCallBack(LHF(_getJsondata), HTTP_GET, "jsondata", false);
+    _alpacaServer->onSetup(url, HTTP_GET, LHF(_getJsondata));
     // setup json post handler
     AsyncCallbackJsonWebHandler *jsonhandler = new AsyncCallbackJsonWebHandler(url, [this](AsyncWebServerRequest *request, JsonVariant &json) {
         JsonObject jsonObj = json.as<JsonObject>();
         this->aReadJson(jsonObj);
         request->send(200, F("application/json"), F("{\"recieved\":\"true\"}"));
     });
-    _alpacaServer->getServerTCP()->addHandler(jsonhandler);
+    _alpacaServer->addSetupHandler(jsonhandler);
 
     // serve static setup page
-    _alpacaServer->logMessage("[ALPACA] Register handler for \"" + String(_device_url) + "\" to /www/setup.html");
-    _alpacaServer->getServerTCP()->serveStatic(_device_url, LittleFS, "/www/setup.html");
+    if (_alpacaServer->logEnabled())
+        _alpacaServer->logMessage("[ALPACA] Register handler for \"" + String(_device_url) + "\" to /www/setup.html");
+    _alpacaServer->serveSetup(_device_url, "/www/setup.html");
 }
 
 // register callbacks for REST API
 void AlpacaDevice::registerCallbacks() {
-    this->createCallBack(LHF(aPutAction), HTTP_PUT, "action", false);
-    this->createCallBack(LHF(aPutCommandBlind), HTTP_PUT, "commandblind", false);
-    this->createCallBack(LHF(aPutCommandBool), HTTP_PUT, "commandbool", false);
-    this->createCallBack(LHF(aPutCommandString), HTTP_PUT, "commandstring", false);
-    this->createCallBack(LHF(aGetConnected), HTTP_GET, "connected", false);
-    this->createCallBack(LHF(aPutConnected), HTTP_PUT, "connected", false);
-    this->createCallBack(LHF(aGetDescription), HTTP_GET, "description", false);
-    this->createCallBack(LHF(aGetDriverInfo), HTTP_GET, "driverinfo", false);
-    this->createCallBack(LHF(aGetDriverVersion), HTTP_GET, "driverversion", false);
-    this->createCallBack(LHF(aGetInterfaceVersion), HTTP_GET, "interfaceversion", false);
-    this->createCallBack(LHF(aGetName), HTTP_GET, "name", false);
-    this->createCallBack(LHF(aGetSupportedActions), HTTP_GET, "supportedactions", false);
+    static const AlpacaBinding common[] = {
+        ALPACA_RAW(AlpacaDevice, "action", HTTP_PUT, aPutAction),
+        ALPACA_RAW(AlpacaDevice, "commandblind", HTTP_PUT, aPutCommandBlind),
+        ALPACA_RAW(AlpacaDevice, "commandbool", HTTP_PUT, aPutCommandBool),
+        ALPACA_RAW(AlpacaDevice, "commandstring", HTTP_PUT, aPutCommandString),
+        ALPACA_RAW(AlpacaDevice, "connected", HTTP_GET, aGetConnected),
+        ALPACA_RAW(AlpacaDevice, "connected", HTTP_PUT, aPutConnected),
+        ALPACA_RAW(AlpacaDevice, "description", HTTP_GET, aGetDescription),
+        ALPACA_RAW(AlpacaDevice, "driverinfo", HTTP_GET, aGetDriverInfo),
+        ALPACA_RAW(AlpacaDevice, "driverversion", HTTP_GET, aGetDriverVersion),
+        ALPACA_RAW(AlpacaDevice, "interfaceversion", HTTP_GET, aGetInterfaceVersion),
+        ALPACA_RAW_BINARY(AlpacaDevice, "name", aGetName),
+        ALPACA_RAW_BINARY(AlpacaDevice, "supportedactions", aGetSupportedActions),
+    };
+    bind(common, false);
 
     _setSetupPage();
 }
 
+// flash work such as mounting files or replaying data, called by the server after the api is up
+void AlpacaDevice::beginDeferred() {
+}
+
 void AlpacaDevice::setDeviceNumber(int8_t device_number) {
     _device_number = device_number;
     snprintf(_device_url, sizeof(_device_url), ALPACA_DEVICE_COMMAND, _device_type, _device_number, "setup");
-    snprintf(_device_name, sizeof(_device_name), ALPACA_DEFAULT_NAME, _device_type, _device_number);
+    _config.update([this](AlpacaDeviceConfig &config) { snprintf(config.name, sizeof(config.name), ALPACA_DEFAULT_NAME, _device_type, _device_number); });
     snprintf(_device_uid, sizeof(_device_uid), ALPACA_UNIQUE_NAME, _device_type, _alpacaServer->getUID(), _device_number);
 }
 
@@ -79,14 +127,20 @@ void AlpacaDevice::aPutCommandString(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, nullptr, NotImplemented);
 };
 void AlpacaDevice::aGetConnected(AsyncWebServerRequest *request) {
-    _alpacaServer->respond(request, (_isconnected ? "true" : "false"));
+    _alpacaServer->respond(request, _alpacaServer->isConnected(request, this));
 };
+// connected per ClientID, the device disconnects when its last client does
 void AlpacaDevice::aPutConnected(AsyncWebServerRequest *request) {
-    _isconnected = !_isconnected;
-    _alpacaServer->respond(request, (_isconnected ? "true" : "false")); // bug correction
+    bool connected;
+    if (!_alpacaServer->getParam(request, "Connected", connected)) {
+        _alpacaServer->respond(request, nullptr, InvalidValue, "Missing parameter Connected");
+        return;
+    }
+    _isconnected = _alpacaServer->connectDevice(request, this, connected);
+    _alpacaServer->respond(request, nullptr);
 };
 void AlpacaDevice::aGetDescription(AsyncWebServerRequest *request) {
-    _alpacaServer->respond(request, _device_desc);
+    _alpacaServer->respond(request, _config.read()->desc);
 };
 void AlpacaDevice::aGetDriverInfo(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, ALPACA_DRIVER_INFO);
@@ -95,26 +149,29 @@ void AlpacaDevice::aGetDriverVersion(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, ALPACA_DRIVER_VER);
 };
 void AlpacaDevice::aGetName(AsyncWebServerRequest *request) {
-    _alpacaServer->respond(request, getDeviceName());
+    _alpacaServer->respond(request, _config.read()->name);
 };
 void AlpacaDevice::aGetSupportedActions(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, _supported_actions);
 };
 
 void AlpacaDevice::aReadJson(JsonObject &root) {
-    const char *name = root[F("General")][F("Name")];
-    if (name)
-        strlcpy(_device_name, name, sizeof(_device_name));
-    const char *desc = root[F("General")][F("Description")];
-    if (desc)
-        strlcpy(_device_desc, desc, sizeof(_device_name));
+    _config.update([&root](AlpacaDeviceConfig &config) {
+        const char *name = root[F("General")][F("Name")];
+        if (name)
+            strlcpy(config.name, name, sizeof(config.name));
+        const char *desc = root[F("General")][F("Description")];
+        if (desc)
+            strlcpy(config.desc, desc, sizeof(config.desc));
+    });
 }
 
 void AlpacaDevice::aWriteJson(JsonObject &root) {
     // read-only values marked with #
     JsonObject obj_general = root[F("General")].to<JsonObject>();
-    obj_general[F("Namezro")] = getDeviceName();
-    obj_general[F("Descriptionzro")] = _device_desc;
+    auto config = _config.read();
+    obj_general[F("Namezro")] = config->name;
+    obj_general[F("Descriptionzro")] = config->desc;
     obj_general[F("UIDzro")] = _device_uid;
 }
 
@@ -124,5 +181,5 @@ void AlpacaDevice::_getJsondata(AsyncWebServerRequest *request) {
     aWriteJson(root);
     String ser_json = "";
     serializeJson(root, ser_json);
-    request->send(200, ALPACA_JSON_TYPE, ser_json);
+    _alpacaServer->sendJson(request, ser_json);
 }
\ No newline at end of file
@@ -1,25 +1,35 @@
 #pragma once
 #include "AlpacaServer.h"
+#include "AlpacaBinding.h"
 
 class AlpacaDevice {
   protected:
     // pointer to server
     AlpacaServer *_alpacaServer;
     // naming and numbering
-    char _device_name[33] = "";
     char _device_type[30] = ""; // char _device_type[17] = "";
     char _device_uid[32] = "";
-    char _device_desc[65] = "Alpaca ESP32 driver";
     char _device_url[65] = "http://github/agnunez/AlpacaServerSP32";
     char _supported_actions[512] = "[]";
     int8_t _device_number = -1;
     bool _isconnected = false;
+    // name and description, replaced as a whole by aReadJson, set them with the setters below
+    AlpacaSnapshot<AlpacaDeviceConfig> _config;
+    // single web handler for all bound commands
+    AlpacaBindingHandler *_bindings = nullptr;
 
     // common functions
     virtual void _setSetupPage();
     void _getJsondata(AsyncWebServerRequest *request);
     void _putJsondata(AsyncWebServerRequest *request);
     void createCallBack(ArRequestHandlerFunction fn, WebRequestMethodComposite type, const char command[], bool deviceMethod = true);
+    void bind(const AlpacaBinding *table, size_t size, bool deviceMethods = true);
+    template <size_t N>
+    void bind(const AlpacaBinding (&table)[N], bool deviceMethods = true) { bind(table, N, deviceMethods); }
+    void _addSupportedAction(const char *command);
+    // replace the former _device_name and _device_desc members, the name is reset by addDevice()
+    void setDeviceName(const char *name);
+    void setDeviceDescription(const char *desc);
 
     // alpaca commands
     virtual void aPutAction(AsyncWebServerRequest *request);
@@ -36,12 +46,20 @@ class AlpacaDevice {
     void aGetSupportedActions(AsyncWebServerRequest *request);
 
   public:
+    AlpacaDevice();
     void virtual registerCallbacks();
+    void virtual beginDeferred();
+    void registerSetupCallbacks() { _setSetupPage(); }
     void setAlpacaServer(AlpacaServer *alpaca_server) { _alpacaServer = alpaca_server; }
+    AlpacaServer *getAlpacaServer() { return _alpacaServer; }
+    bool isConnected() { return _isconnected; }
+    void setConnected(bool connected) { _isconnected = connected; }
+    const AlpacaBinding *findBinding(const char *command) { return _bindings ? _bindings->find(command, HTTP_GET) : nullptr; }
     void setDeviceNumber(int8_t device_number);
     uint8_t getDeviceNumber() { return _device_number; }
     const char *getDeviceType() { return _device_type; }
-    const char *getDeviceName() { return _device_name; };
+    String getDeviceName() { return String(_config.read()->name); };
+    AlpacaSnapshot<AlpacaDeviceConfig>::Reader readConfig() { return _config.read(); }
     const char *getDeviceUID() { return _device_uid; }
     const char *getDeviceURL() { return _device_url; };
     virtual void aReadJson(JsonObject &root);
@@ -2,20 +2,60 @@
 
 void AlpacaFocuser::registerCallbacks() {
     AlpacaDevice::registerCallbacks();
-    this->createCallBack(LHF(aGetAbsolute), HTTP_GET, "absolute");
-    this->createCallBack(LHF(aGetIsMoving), HTTP_GET, "ismoving");
-    this->createCallBack(LHF(aGetMaxIncrement), HTTP_GET, "maxincrement");
-    this->createCallBack(LHF(aGetMaxStep), HTTP_GET, "maxstep");
-    this->createCallBack(LHF(aGetPosition), HTTP_GET, "position");
-    this->createCallBack(LHF(aGetStepSize), HTTP_GET, "stepsize");
-    this->createCallBack(LHF(aGetTempComp), HTTP_GET, "tempcomp");
-    this->createCallBack(LHF(aPutTempComp), HTTP_PUT, "tempcomp");
-    this->createCallBack(LHF(aGetTempCompAvailable), HTTP_GET, "tempcompavailable");
-    this->createCallBack(LHF(aGetTemperature), HTTP_GET, "temperature");
-    this->createCallBack(LHF(aPutHalt), HTTP_PUT, "halt");
-    this->createCallBack(LHF(aPutMove), HTTP_PUT, "move");
+    static const AlpacaBinding commands[] = {
+        ALPACA_DEFAULT(AlpacaFocuser, "absolute", HTTP_GET, aGetAbsolute),
+        ALPACA_DEFAULT(AlpacaFocuser, "ismoving", HTTP_GET, aGetIsMoving),
+        ALPACA_DEFAULT(AlpacaFocuser, "maxincrement", HTTP_GET, aGetMaxIncrement),
+        ALPACA_DEFAULT(AlpacaFocuser, "maxstep", HTTP_GET, aGetMaxStep),
+        ALPACA_DEFAULT(AlpacaFocuser, "position", HTTP_GET, aGetPosition),
+        ALPACA_DEFAULT(AlpacaFocuser, "stepsize", HTTP_GET, aGetStepSize),
+        ALPACA_DEFAULT(AlpacaFocuser, "tempcomp", HTTP_GET, aGetTempComp),
+        ALPACA_DEFAULT(AlpacaFocuser, "tempcomp", HTTP_PUT, aPutTempComp),
+        ALPACA_DEFAULT(AlpacaFocuser, "tempcompavailable", HTTP_GET, aGetTempCompAvailable),
+        ALPACA_DEFAULT(AlpacaFocuser, "temperature", HTTP_GET, aGetTemperature),
+        ALPACA_DEFAULT(AlpacaFocuser, "halt", HTTP_PUT, aPutHalt),
+        ALPACA_DEFAULT(AlpacaFocuser, "move", HTTP_PUT, aPutMove),
+    };
+    bind(commands);
 }
 
 void AlpacaFocuser::aGetInterfaceVersion(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, ALPACA_FOCUSER_INTERFACE_VERSION);
 };
+
+void AlpacaFocuser::aGetAbsolute(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetIsMoving(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetMaxIncrement(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetMaxStep(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetPosition(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetStepSize(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetTempComp(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aPutTempComp(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetTempCompAvailable(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aGetTemperature(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aPutHalt(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaFocuser::aPutMove(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
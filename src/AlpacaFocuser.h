@@ -5,20 +5,20 @@
 
 class AlpacaFocuser : public AlpacaDevice {
   protected:
-    // alpaca commands
+    // alpaca commands, defaults answer NotImplemented
     void aGetInterfaceVersion(AsyncWebServerRequest *request);
-    virtual void aGetAbsolute(AsyncWebServerRequest *request) = 0;
-    virtual void aGetIsMoving(AsyncWebServerRequest *request) = 0;
-    virtual void aGetMaxIncrement(AsyncWebServerRequest *request) = 0;
-    virtual void aGetMaxStep(AsyncWebServerRequest *request) = 0;
-    virtual void aGetPosition(AsyncWebServerRequest *request) = 0;
-    virtual void aGetStepSize(AsyncWebServerRequest *request) = 0;
-    virtual void aGetTempComp(AsyncWebServerRequest *request) = 0;
-    virtual void aPutTempComp(AsyncWebServerRequest *request) = 0;
-    virtual void aGetTempCompAvailable(AsyncWebServerRequest *request) = 0;
-    virtual void aGetTemperature(AsyncWebServerRequest *request) = 0;
-    virtual void aPutHalt(AsyncWebServerRequest *request) = 0;
-    virtual void aPutMove(AsyncWebServerRequest *request) = 0;
+    virtual void aGetAbsolute(AsyncWebServerRequest *request);
+    virtual void aGetIsMoving(AsyncWebServerRequest *request);
+    virtual void aGetMaxIncrement(AsyncWebServerRequest *request);
+    virtual void aGetMaxStep(AsyncWebServerRequest *request);
+    virtual void aGetPosition(AsyncWebServerRequest *request);
+    virtual void aGetStepSize(AsyncWebServerRequest *request);
+    virtual void aGetTempComp(AsyncWebServerRequest *request);
+    virtual void aPutTempComp(AsyncWebServerRequest *request);
+    virtual void aGetTempCompAvailable(AsyncWebServerRequest *request);
+    virtual void aGetTemperature(AsyncWebServerRequest *request);
+    virtual void aPutHalt(AsyncWebServerRequest *request);
+    virtual void aPutMove(AsyncWebServerRequest *request);
     AlpacaFocuser() { strcpy(_device_type, "focuser"); }
 
   public:
@@ -0,0 +1,143 @@
+#include "AlpacaGzip.h"
+#include <esp_rom_crc.h>
+
+// deflate length and distance codes (RFC 1951 3.2.5)
+static const uint16_t LEN_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LEN_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+AlpacaGzip::AlpacaGzip() {
+    _lock = xSemaphoreCreateMutex();
+}
+
+// take the working buffers without waiting, callers send uncompressed if busy
+bool AlpacaGzip::lock() {
+    return _lock && xSemaphoreTake(_lock, 0) == pdTRUE;
+}
+
+void AlpacaGzip::unlock() {
+    xSemaphoreGive(_lock);
+}
+
+void AlpacaGzip::_putByte(uint8_t b) {
+    _out[_n_out++] = b;
+    if (_n_out == ALPACA_GZIP_OUT_SIZE) {
+        _written += _sink->write(_out, _n_out);
+        _n_out = 0;
+    }
+}
+
+// plain values are packed lsb first
+void AlpacaGzip::_putBits(uint32_t value, int bits) {
+    _bitbuf |= value << _bitcount;
+    _bitcount += bits;
+    while (_bitcount >= 8) {
+        _putByte(_bitbuf & 0xFF);
+        _bitbuf >>= 8;
+        _bitcount -= 8;
+    }
+}
+
+// huffman codes are packed msb first
+void AlpacaGzip::_putCode(uint32_t code, int bits) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < bits; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    _putBits(reversed, bits);
+}
+
+// fixed literal/length table
+void AlpacaGzip::_putLiteral(int symbol) {
+    if (symbol < 144)
+        _putCode(0x30 + symbol, 8);
+    else if (symbol < 256)
+        _putCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        _putCode(symbol - 256, 7);
+    else
+        _putCode(0xC0 + symbol - 280, 8);
+}
+
+void AlpacaGzip::_putMatch(int length, int distance) {
+    int l = 28;
+    while (LEN_BASE[l] > length)
+        l--;
+    _putLiteral(257 + l);
+    _putBits(length - LEN_BASE[l], LEN_EXTRA[l]);
+    int d = 29;
+    while (DIST_BASE[d] > distance)
+        d--;
+    _putCode(d, 5);
+    _putBits(distance - DIST_BASE[d], DIST_EXTRA[d]);
+}
+
+void AlpacaGzip::_flush() {
+    if (_bitcount > 0)
+        _putBits(0, 8 - _bitcount);
+    if (_n_out > 0)
+        _written += _sink->write(_out, _n_out);
+    _n_out = 0;
+}
+
+// write data as a gzip member to out, returns number of compressed bytes
+size_t AlpacaGzip::compress(const uint8_t *data, size_t len, Print &out) {
+    static const uint8_t header[10] = {0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF};
+    unsigned long start = micros();
+    _sink = &out;
+    _n_out = 0;
+    _bitbuf = 0;
+    _bitcount = 0;
+    memset(_hash, 0, sizeof(_hash));
+    _written = out.write(header, sizeof(header));
+
+    // single final block with fixed huffman codes
+    _putBits(1, 1);
+    _putBits(1, 2);
+    size_t i = 0;
+    while (i < len) {
+        int best = 0;
+        size_t distance = 0;
+        if (i + 3 <= len) {
+            uint32_t h = ((data[i] << 16 | data[i + 1] << 8 | data[i + 2]) * 2654435761u) >> (32 - ALPACA_GZIP_HASH_BITS);
+            uint32_t candidate = _hash[h];
+            _hash[h] = i + 1; // 0 marks an empty slot
+            if (candidate > 0 && i - (candidate - 1) <= ALPACA_GZIP_WINDOW) {
+                const uint8_t *p = data + candidate - 1;
+                size_t limit = min(len - i, (size_t)ALPACA_GZIP_MAX_MATCH);
+                while ((size_t)best < limit && p[best] == data[i + best])
+                    best++;
+                distance = data + i - p;
+            }
+        }
+        if (best >= 3) {
+            _putMatch(best, distance);
+            // index the positions covered by the match
+            for (size_t j = i + 1; j < i + best && j + 3 <= len; j++) {
+                uint32_t h = ((data[j] << 16 | data[j + 1] << 8 | data[j + 2]) * 2654435761u) >> (32 - ALPACA_GZIP_HASH_BITS);
+                _hash[h] = j + 1;
+            }
+            i += best;
+        } else {
+            _putLiteral(data[i]);
+            i++;
+        }
+    }
+    _putLiteral(256);
+    _flush();
+
+    uint32_t crc = esp_rom_crc32_le(0, data, len);
+    uint8_t trailer[8] = {
+        (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24),
+        (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24)};
+    _written += out.write(trailer, sizeof(trailer));
+    _sink = nullptr;
+
+    stats.compressed++;
+    stats.bytesIn += len;
+    stats.bytesOut += _written;
+    stats.micros += micros() - start;
+    return _written;
+}
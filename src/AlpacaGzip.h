@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_GZIP_THRESHOLD
+#define ALPACA_GZIP_THRESHOLD 512 // smaller bodies are sent uncompressed
+#endif
+#define ALPACA_GZIP_HASH_BITS 10
+#define ALPACA_GZIP_WINDOW 32768
+#define ALPACA_GZIP_MAX_MATCH 258
+#define ALPACA_GZIP_OUT_SIZE 128
+
+// compression statistics, sizes in bytes and time in microseconds
+typedef struct {
+    uint32_t responses;
+    uint32_t compressed;
+    uint32_t bytesIn;
+    uint32_t bytesOut;
+    uint32_t micros;
+} AlpacaGzipStats;
+
+// Single pass gzip encoder (LZ77 with one hash probe and the fixed deflate huffman table).
+// Working buffers are owned by the object and reused, one request at a time.
+class AlpacaGzip {
+  private:
+    SemaphoreHandle_t _lock = nullptr;
+    uint32_t _hash[1 << ALPACA_GZIP_HASH_BITS];
+    uint8_t _out[ALPACA_GZIP_OUT_SIZE];
+    int _n_out = 0;
+    uint32_t _bitbuf = 0;
+    int _bitcount = 0;
+    Print *_sink = nullptr;
+    size_t _written = 0;
+
+    void _putByte(uint8_t b);
+    void _putBits(uint32_t value, int bits);
+    void _putCode(uint32_t code, int bits);
+    void _putLiteral(int symbol);
+    void _putMatch(int length, int distance);
+    void _flush();
+
+  public:
+    AlpacaGzipStats stats = {0, 0, 0, 0, 0};
+
+    AlpacaGzip();
+    bool lock();
+    void unlock();
+    size_t compress(const uint8_t *data, size_t len, Print &out);
+};
@@ -3,6 +3,12 @@
 
 // settings
 #define ALPACA_MAX_DEVICES 8
+#define ALPACA_BOOT_PHASES 24
+#define ALPACA_TRACE_FILE "/trace.bin"
+#define ALPACA_SETUP_HANDLERS (8 + 3 * ALPACA_MAX_DEVICES) // server and per device setup handlers
+#ifndef ALPACA_DEFER_TIMEOUT
+#define ALPACA_DEFER_TIMEOUT 2000 // ms after begin() before deferred init runs without update()
+#endif
 
 #define ALPACA_DISCOVERY_HEADER "alpacadiscovery"
 #define ALPACA_DISCOVERY_LENGTH 64
@@ -26,6 +32,29 @@ typedef union {
     char buffer[ALPACA_DISCOVERY_LENGTH];
 } AlpacaDiscoveryBuffer;
 
+// boot timeline entry, times in microseconds since reset
+typedef struct
+{
+    const char *name;
+    int8_t device;
+    uint32_t start;
+    uint32_t duration;
+} AlpacaBootPhase;
+
+// configuration snapshots, published through AlpacaSnapshot
+typedef struct
+{
+    char name[32];
+    uint16_t portTCP;
+    uint16_t portUDP;
+} AlpacaServerConfig;
+
+typedef struct
+{
+    char name[33];
+    char desc[65];
+} AlpacaDeviceConfig;
+
 // return
 #define ALPACA_API_VERSIONS "[1]"
 #define ALPACA_DRIVER_VER "v2.0"
@@ -67,4 +96,9 @@ enum AlpacaErrorCode : int32_t {
     AlpacaParkedException = 0x408,               // Movement (or other invalid operation) was attempted while the device was in a parked state.
     AlpacaSlavedException = 0x409,               // Movement (or other invalid operation) was attempted while the device was in slaved mode. This applies primarily to Dome drivers.
     AlpacaValueNotSetException = 0x402           // No value has yet been set for this property.
-};
\ No newline at end of file
+};
+
+// AscomErrorCode values (0x8004xxxx) as alpaca error numbers (0x400 - 0xFFF), others unchanged
+inline int32_t alpacaErrorNumber(int32_t error) {
+    return ((uint32_t)error & 0xFFFFF000) == 0x80040000 ? (error & 0xFFF) : error;
+}
\ No newline at end of file
@@ -0,0 +1,462 @@
+#include "AlpacaHistory.h"
+#include "AlpacaServer.h"
+
+// channel names and fixed point scale (counts per unit)
+static const char *const HISTORY_NAME[ALPACA_HISTORY_CHANNELS] = {
+    "cloudcover", "dewpoint", "humidity", "pressure", "rainrate", "skybrightness", "skyquality",
+    "skytemperature", "starfwhm", "temperature", "winddirection", "windgust", "windspeed"};
+static const float HISTORY_SCALE[ALPACA_HISTORY_CHANNELS] = {
+    100.0f, 100.0f, 100.0f, 10.0f, 100.0f, 1.0f, 100.0f,
+    100.0f, 100.0f, 100.0f, 10.0f, 100.0f, 100.0f};
+
+// rollup levels as {resolution in seconds, buckets}: 2 hours, 1 day and 1 week
+static const uint32_t HISTORY_LEVEL[ALPACA_HISTORY_LEVELS][2] = {{60, 120}, {900, 96}, {3600, 168}};
+
+AlpacaHistory::AlpacaHistory() {
+    for (int i = 0; i < ALPACA_HISTORY_LEVELS; i++) {
+        _rollup[i].resolution = HISTORY_LEVEL[i][0];
+        _rollup[i].capacity = HISTORY_LEVEL[i][1];
+        _rollup[i].head = 0;
+        _rollup[i].count = 0;
+        _rollup[i].bucket = nullptr;
+    }
+    memset(_lastValue, 0, sizeof(_lastValue));
+    memset(_flushValue, 0, sizeof(_flushValue));
+}
+
+// set storage directory and rebuild rollups from flash, buffers are only allocated if there is history
+void AlpacaHistory::begin(AlpacaServer *alpaca_server, const char *name) {
+    _alpacaServer = alpaca_server;
+    snprintf(_dir, sizeof(_dir), "%s/%s", ALPACA_HISTORY_DIR, name);
+    if (!LittleFS.exists(ALPACA_HISTORY_DIR))
+        LittleFS.mkdir(ALPACA_HISTORY_DIR);
+    if (!LittleFS.exists(_dir))
+        LittleFS.mkdir(_dir);
+    else
+        _replay();
+    // begin() may run on the deferred init task, record() and query() wait for the lock
+    _lock = xSemaphoreCreateMutex();
+}
+
+// prefer psram for the buffers when the board has it
+void *AlpacaHistory::_calloc(size_t size) {
+    void *ptr = nullptr;
+    if (psramFound())
+        ptr = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM);
+    if (ptr == nullptr)
+        ptr = calloc(1, size);
+    return ptr;
+}
+
+void AlpacaHistory::_release() {
+    for (int i = 0; i < ALPACA_HISTORY_LEVELS; i++) {
+        free(_rollup[i].bucket);
+        _rollup[i].bucket = nullptr;
+    }
+    free(_staging);
+    free(_ring);
+    _staging = nullptr;
+    _ring = nullptr;
+}
+
+// allocate once, a failure is latched so record() doesn't retry on every sample
+bool AlpacaHistory::_allocate() {
+    if (_ring)
+        return true;
+    if (_failed)
+        return false;
+    bool ok = true;
+    for (int i = 0; i < ALPACA_HISTORY_LEVELS; i++) {
+        _rollup[i].bucket = (AlpacaHistoryBucket *)_calloc(_rollup[i].capacity * sizeof(AlpacaHistoryBucket));
+        ok = ok && _rollup[i].bucket;
+    }
+    _staging = (uint8_t *)_calloc(ALPACA_HISTORY_FLUSH_SAMPLES * ALPACA_HISTORY_MAX_SAMPLE);
+    _ring = (uint8_t *)_calloc(ALPACA_HISTORY_RAW_BYTES);
+    if (!ok || _staging == nullptr || _ring == nullptr) {
+        if (_alpacaServer)
+            _alpacaServer->logMessage(F("[ALPACA] History - out of memory"));
+        _release();
+        _failed = true;
+        return false;
+    }
+    return true;
+}
+
+uint32_t AlpacaHistory::_now() {
+    time_t now;
+    time(&now);
+    return (uint32_t)now;
+}
+
+String AlpacaHistory::_segmentPath(uint32_t segment) {
+    return String(_dir) + "/" + String(segment) + ".bin";
+}
+
+static size_t putVarint(uint8_t *out, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    out[n++] = value;
+    return n;
+}
+
+// reads encoded samples from the ring or a flash block, pos wraps at size
+typedef struct {
+    const uint8_t *buf;
+    size_t size;
+    size_t pos;
+    size_t left;
+} HistoryReader;
+
+static bool getVarint(HistoryReader &in, uint32_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && in.left > 0; shift += 7) {
+        uint8_t b = in.buf[in.pos];
+        in.pos = (in.pos + 1) % in.size;
+        in.left--;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// decode the next sample, time and state are advanced, channels not in the sample are ALPACA_HISTORY_NONE
+static bool decodeSample(HistoryReader &in, uint32_t &time, int16_t *state, int16_t *value) {
+    uint32_t dt, mask, delta;
+    if (!getVarint(in, dt) || !getVarint(in, mask))
+        return false;
+    time += dt;
+    for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+        value[c] = ALPACA_HISTORY_NONE;
+        if (!(mask & (1u << c)))
+            continue;
+        if (!getVarint(in, delta))
+            return false;
+        state[c] = (int16_t)(state[c] + ((int32_t)(delta >> 1) ^ -(int32_t)(delta & 1)));
+        value[c] = state[c];
+    }
+    return true;
+}
+
+// encode against the newest sample and advance it, call with the lock held
+size_t AlpacaHistory::_encode(uint8_t *out, uint32_t time, const int16_t *value) {
+    uint32_t mask = 0;
+    for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+        if (value[c] != ALPACA_HISTORY_NONE)
+            mask |= 1u << c;
+    }
+    size_t len = putVarint(out, time - _lastTime);
+    len += putVarint(out + len, mask);
+    for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+        if (!(mask & (1u << c)))
+            continue;
+        int32_t delta = (int32_t)value[c] - _lastValue[c];
+        len += putVarint(out + len, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+    }
+    return len;
+}
+
+// the ring is full because flash writes fail, give up the oldest unflushed sample
+void AlpacaHistory::_dropOldest() {
+    int16_t value[ALPACA_HISTORY_CHANNELS];
+    HistoryReader in = {_ring, ALPACA_HISTORY_RAW_BYTES, _tail, _used};
+    if (!decodeSample(in, _flushTime, _flushValue, value)) {
+        _used = 0;
+        _unflushed = 0;
+        return;
+    }
+    _used = in.left;
+    _tail = in.pos;
+    _unflushed--;
+}
+
+// add one sample to every rollup level, samples older than the newest bucket are dropped
+void AlpacaHistory::_aggregate(uint32_t time, const int16_t *value) {
+    for (int i = 0; i < ALPACA_HISTORY_LEVELS; i++) {
+        AlpacaHistoryRollup &level = _rollup[i];
+        uint32_t start = time - time % level.resolution;
+        if (level.count == 0 || start > level.bucket[level.head].start) {
+            level.head = (level.count == 0) ? 0 : (level.head + 1) % level.capacity;
+            if (level.count < level.capacity)
+                level.count++;
+            AlpacaHistoryBucket &bucket = level.bucket[level.head];
+            memset(&bucket, 0, sizeof(bucket));
+            bucket.start = start;
+        } else if (start < level.bucket[level.head].start) {
+            continue;
+        }
+        AlpacaHistoryBucket &bucket = level.bucket[level.head];
+        for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+            if (value[c] == ALPACA_HISTORY_NONE)
+                continue;
+            AlpacaHistoryAggregate &agg = bucket.channel[c];
+            if (agg.count == 0 || value[c] < agg.min)
+                agg.min = value[c];
+            if (agg.count == 0 || value[c] > agg.max)
+                agg.max = value[c];
+            // a full bucket keeps min/max, the mean stays that of the first 65535 samples
+            if (agg.count < UINT16_MAX) {
+                agg.sum += value[c];
+                agg.count++;
+            }
+        }
+    }
+}
+
+// record a sample, values set to NAN are treated as not available
+void AlpacaHistory::record(const float *value, uint32_t time) {
+    if (_lock == nullptr || !_allocate())
+        return;
+    if (time == 0)
+        time = _now();
+
+    int16_t fixed[ALPACA_HISTORY_CHANNELS];
+    for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+        if (isnan(value[c])) {
+            fixed[c] = ALPACA_HISTORY_NONE;
+        } else {
+            float v = roundf(value[c] * HISTORY_SCALE[c]);
+            fixed[c] = (int16_t)constrain(v, (float)(INT16_MIN + 1), (float)INT16_MAX);
+        }
+    }
+
+    // time going backwards starts a new block
+    if (_unflushed > 0 && time < _lastTime)
+        flush();
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if (_unflushed == 0) {
+        _lastTime = time;
+        _flushTime = time;
+        memcpy(_flushValue, _lastValue, sizeof(_flushValue));
+    }
+    if (time >= _lastTime) {
+        uint8_t encoded[ALPACA_HISTORY_MAX_SAMPLE];
+        size_t len = _encode(encoded, time, fixed);
+        while (_used + len > ALPACA_HISTORY_RAW_BYTES && _unflushed > 0 && !_flushing)
+            _dropOldest();
+        // while a flush is writing, samples that don't fit only go to the rollups
+        if (_used + len <= ALPACA_HISTORY_RAW_BYTES) {
+            for (size_t i = 0; i < len; i++)
+                _ring[(_tail + _used + i) % ALPACA_HISTORY_RAW_BYTES] = encoded[i];
+            _used += len;
+            _unflushed++;
+            _lastTime = time;
+            for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+                if (fixed[c] != ALPACA_HISTORY_NONE)
+                    _lastValue[c] = fixed[c];
+            }
+        }
+    }
+    _aggregate(time, fixed);
+    xSemaphoreGive(_lock);
+
+    if (_unflushed >= ALPACA_HISTORY_FLUSH_SAMPLES || time - _flushTime >= ALPACA_HISTORY_FLUSH_INTERVAL)
+        flush();
+}
+
+// append unflushed samples to the current segment in blocks of ALPACA_HISTORY_FLUSH_SAMPLES
+bool AlpacaHistory::flush() {
+    if (_lock == nullptr || _ring == nullptr)
+        return true;
+    while (_unflushed > 0) {
+        // copy out under lock, flash is written without holding it
+        AlpacaHistoryBlock block;
+        int16_t state[ALPACA_HISTORY_CHANNELS];
+        int16_t value[ALPACA_HISTORY_CHANNELS];
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        block.magic = ALPACA_HISTORY_MAGIC;
+        block.time = _flushTime;
+        memcpy(block.base, _flushValue, sizeof(block.base));
+        memcpy(state, _flushValue, sizeof(state));
+        uint32_t time = _flushTime;
+        HistoryReader in = {_ring, ALPACA_HISTORY_RAW_BYTES, _tail, _used};
+        int count = 0;
+        while (count < min((int)_unflushed, ALPACA_HISTORY_FLUSH_SAMPLES) && decodeSample(in, time, state, value))
+            count++;
+        block.count = count;
+        block.size = _used - in.left;
+        for (size_t i = 0; i < block.size; i++)
+            _staging[i] = _ring[(_tail + i) % ALPACA_HISTORY_RAW_BYTES];
+        _flushing = true;
+        xSemaphoreGive(_lock);
+        if (count == 0)
+            break;
+
+        File file = LittleFS.open(_segmentPath(_segment), FILE_APPEND);
+        size_t written = 0;
+        if (file) {
+            written = file.write((const uint8_t *)&block, sizeof(block));
+            if (written == sizeof(block))
+                written += file.write(_staging, block.size);
+        }
+        // a full or failing filesystem keeps the samples in the ring for the next flush
+        bool ok = written == sizeof(block) + block.size;
+        size_t size = file ? file.size() : 0;
+
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        _flushing = false;
+        if (ok) {
+            _tail = (_tail + block.size) % ALPACA_HISTORY_RAW_BYTES;
+            _used -= block.size;
+            _unflushed -= count;
+            _flushTime = time;
+            memcpy(_flushValue, state, sizeof(_flushValue));
+        }
+        xSemaphoreGive(_lock);
+        if (!file) {
+            if (_alpacaServer)
+                _alpacaServer->logMessage(F("[ALPACA] History - could not open segment"));
+            return false;
+        }
+        file.close();
+        if (!ok && _alpacaServer)
+            _alpacaServer->logMessage(F("[ALPACA] History - could not write segment"));
+
+        // rotate segment and drop the oldest one, a torn block ends its segment so later blocks stay readable
+        if ((!ok && written > 0) || size >= ALPACA_HISTORY_SEGMENT_SIZE) {
+            _segment++;
+            if (_segment >= ALPACA_HISTORY_SEGMENTS)
+                LittleFS.remove(_segmentPath(_segment - ALPACA_HISTORY_SEGMENTS));
+        }
+        if (!ok)
+            return false;
+    }
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _flushing = false;
+    xSemaphoreGive(_lock);
+    return true;
+}
+
+// rebuild rollups from the segments on flash
+void AlpacaHistory::_replay() {
+    File dir = LittleFS.open(_dir);
+    if (!dir || !dir.isDirectory())
+        return;
+    uint32_t first = UINT32_MAX;
+    uint32_t last = 0;
+    bool found = false;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        uint32_t segment = strtoul(file.name(), nullptr, 10);
+        first = min(first, segment);
+        last = max(last, segment);
+        found = true;
+        file.close();
+    }
+    dir.close();
+    if (!found || !_allocate())
+        return;
+
+    unsigned long start = millis();
+    for (uint32_t segment = first; segment <= last; segment++) {
+        File file = LittleFS.open(_segmentPath(segment), FILE_READ);
+        if (file) {
+            _replaySegment(file);
+            file.close();
+        }
+    }
+    _segment = last;
+    if (_alpacaServer)
+        _alpacaServer->logMessage("[ALPACA] History - replayed " + String(last - first + 1) + " segments in " + String(millis() - start) + " ms");
+}
+
+void AlpacaHistory::_replaySegment(File &file) {
+    AlpacaHistoryBlock block;
+    int16_t state[ALPACA_HISTORY_CHANNELS];
+    int16_t value[ALPACA_HISTORY_CHANNELS];
+    while (file.read((uint8_t *)&block, sizeof(block)) == sizeof(block)) {
+        // torn write or older format, ignore the rest of the segment
+        if (block.magic != ALPACA_HISTORY_MAGIC || block.size > ALPACA_HISTORY_FLUSH_SAMPLES * ALPACA_HISTORY_MAX_SAMPLE)
+            return;
+        if (file.read(_staging, block.size) != block.size)
+            return;
+        HistoryReader in = {_staging, block.size, 0, block.size};
+        uint32_t time = block.time;
+        memcpy(state, block.base, sizeof(state));
+        for (int i = 0; i < block.count; i++) {
+            if (!decodeSample(in, time, state, value))
+                return;
+            _aggregate(time, value);
+        }
+    }
+}
+
+// fill buckets with [start, min, max, mean] from the finest rollup that still holds from
+// returns the resolution actually used
+uint32_t AlpacaHistory::query(AlpacaHistoryChannel channel, uint32_t from, uint32_t to, uint32_t resolution, JsonArray buckets) {
+    if (channel >= ALPACA_HISTORY_CHANNELS || to < from || _lock == nullptr)
+        return 0;
+    if ((to - from) / max(resolution, (uint32_t)1) > ALPACA_HISTORY_MAX_BUCKETS)
+        resolution = (to - from + ALPACA_HISTORY_MAX_BUCKETS - 1) / ALPACA_HISTORY_MAX_BUCKETS;
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    // a level covers from if it never wrapped or its oldest bucket is not newer, else fall back to coarser ones
+    int l = ALPACA_HISTORY_LEVELS - 1;
+    for (int i = 0; i < ALPACA_HISTORY_LEVELS; i++) {
+        const AlpacaHistoryRollup &level = _rollup[i];
+        if (level.bucket == nullptr || level.count < level.capacity ||
+            level.bucket[(level.head + 1) % level.capacity].start <= from) {
+            l = i;
+            break;
+        }
+    }
+    const AlpacaHistoryRollup &level = _rollup[l];
+    resolution = max(resolution, level.resolution);
+    const float scale = HISTORY_SCALE[channel];
+
+    // merged buckets may hold more samples than one rollup bucket
+    struct {
+        int16_t min;
+        int16_t max;
+        int64_t sum;
+        uint32_t count;
+    } acc = {0, 0, 0, 0};
+    uint32_t acc_start = 0;
+    auto emit = [&]() {
+        if (acc.count == 0)
+            return;
+        JsonArray row = buckets.add<JsonArray>();
+        row.add(acc_start);
+        row.add(acc.min / scale);
+        row.add(acc.max / scale);
+        row.add((float)((double)acc.sum / acc.count / scale));
+    };
+
+    for (int i = 0; i < level.count && level.bucket; i++) {
+        const AlpacaHistoryBucket &bucket = level.bucket[(level.head + level.capacity - level.count + 1 + i) % level.capacity];
+        const AlpacaHistoryAggregate &agg = bucket.channel[channel];
+        if (bucket.start < from || bucket.start > to || agg.count == 0)
+            continue;
+        uint32_t start = from + (bucket.start - from) / resolution * resolution;
+        if (acc.count == 0 || start != acc_start) {
+            emit();
+            acc.min = agg.min;
+            acc.max = agg.max;
+            acc.sum = 0;
+            acc.count = 0;
+            acc_start = start;
+        }
+        acc.min = min(acc.min, agg.min);
+        acc.max = max(acc.max, agg.max);
+        acc.sum += agg.sum;
+        acc.count += agg.count;
+    }
+    emit();
+    xSemaphoreGive(_lock);
+    return resolution;
+}
+
+const char *AlpacaHistory::channelName(uint8_t channel) {
+    return (channel < ALPACA_HISTORY_CHANNELS) ? HISTORY_NAME[channel] : "";
+}
+
+int AlpacaHistory::channelFromName(const char *name) {
+    for (int c = 0; c < ALPACA_HISTORY_CHANNELS; c++) {
+        if (strcasecmp(name, HISTORY_NAME[c]) == 0)
+            return c;
+    }
+    return -1;
+}
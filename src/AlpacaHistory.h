@@ -0,0 +1,125 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_HISTORY_RAW_BYTES
+#define ALPACA_HISTORY_RAW_BYTES 8192 // encoded samples kept in ram waiting for flush
+#endif
+#ifndef ALPACA_HISTORY_FLUSH_SAMPLES
+#define ALPACA_HISTORY_FLUSH_SAMPLES 60 // samples batched into one flash write
+#endif
+#ifndef ALPACA_HISTORY_FLUSH_INTERVAL
+#define ALPACA_HISTORY_FLUSH_INTERVAL 900 // max seconds between flash writes
+#endif
+#ifndef ALPACA_HISTORY_SEGMENT_SIZE
+#define ALPACA_HISTORY_SEGMENT_SIZE 32768 // bytes per segment file
+#endif
+#ifndef ALPACA_HISTORY_SEGMENTS
+#define ALPACA_HISTORY_SEGMENTS 8 // segment files kept on flash
+#endif
+#define ALPACA_HISTORY_MAX_BUCKETS 240
+#define ALPACA_HISTORY_LEVELS 3
+#define ALPACA_HISTORY_DIR "/history"
+#define ALPACA_HISTORY_MAGIC 0xA1CB
+#define ALPACA_HISTORY_NONE INT16_MIN
+
+// Forward declare AlpacaServer, only used for logging
+class AlpacaServer;
+
+// recorded channels, named after the observingconditions properties
+enum AlpacaHistoryChannel : uint8_t {
+    HistoryCloudCover,
+    HistoryDewPoint,
+    HistoryHumidity,
+    HistoryPressure,
+    HistoryRainRate,
+    HistorySkyBrightness,
+    HistorySkyQuality,
+    HistorySkyTemperature,
+    HistoryStarFwhm,
+    HistoryTemperature,
+    HistoryWindDirection,
+    HistoryWindGust,
+    HistoryWindSpeed,
+    ALPACA_HISTORY_CHANNELS
+};
+
+// encoded sample: dt and channel mask as varints, then one zigzag varint delta per present channel
+// against the channel's previous value, so a slowly changing channel takes one byte
+#define ALPACA_HISTORY_MAX_SAMPLE (5 + 2 + 3 * ALPACA_HISTORY_CHANNELS)
+
+// flash block header, followed by size bytes holding count encoded samples
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint16_t count;
+    uint32_t time;                          // time before the first sample
+    uint16_t size;
+    int16_t base[ALPACA_HISTORY_CHANNELS]; // values before the first sample
+} AlpacaHistoryBlock;
+
+typedef struct __attribute__((packed)) {
+    int16_t min;
+    int16_t max;
+    int32_t sum;
+    uint16_t count;
+} AlpacaHistoryAggregate;
+
+typedef struct {
+    uint32_t start;
+    AlpacaHistoryAggregate channel[ALPACA_HISTORY_CHANNELS];
+} AlpacaHistoryBucket;
+
+typedef struct {
+    uint32_t resolution;
+    uint16_t capacity;
+    uint16_t head;
+    uint16_t count;
+    AlpacaHistoryBucket *bucket;
+} AlpacaHistoryRollup;
+
+class AlpacaHistory {
+  private:
+    AlpacaServer *_alpacaServer = nullptr;
+    SemaphoreHandle_t _lock = nullptr;
+    char _dir[48] = "";
+
+    // byte ring of encoded samples, only holds what has not reached flash yet
+    uint8_t *_ring = nullptr;
+    uint8_t *_staging = nullptr;
+    bool _failed = false;
+    size_t _tail = 0;
+    size_t _used = 0;
+    uint16_t _unflushed = 0;
+    bool _flushing = false;
+    // decoder state after the newest sample and before the oldest unflushed one
+    uint32_t _lastTime = 0;
+    int16_t _lastValue[ALPACA_HISTORY_CHANNELS];
+    uint32_t _flushTime = 0;
+    int16_t _flushValue[ALPACA_HISTORY_CHANNELS];
+    uint32_t _segment = 0;
+
+    // pre-aggregated min/max/sum, finest level first
+    AlpacaHistoryRollup _rollup[ALPACA_HISTORY_LEVELS];
+
+    bool _allocate();
+    void _release();
+    void *_calloc(size_t size);
+    size_t _encode(uint8_t *out, uint32_t time, const int16_t *value);
+    void _dropOldest();
+    void _aggregate(uint32_t time, const int16_t *value);
+    void _replay();
+    void _replaySegment(File &file);
+    String _segmentPath(uint32_t segment);
+    uint32_t _now();
+
+  public:
+    AlpacaHistory();
+    void begin(AlpacaServer *alpaca_server, const char *name);
+    void record(const float *value, uint32_t time = 0);
+    bool flush();
+    uint32_t query(AlpacaHistoryChannel channel, uint32_t from, uint32_t to, uint32_t resolution, JsonArray buckets);
+    static const char *channelName(uint8_t channel);
+    static int channelFromName(const char *name);
+};
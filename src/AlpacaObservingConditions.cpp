@@ -2,26 +2,125 @@
 
 void AlpacaObservingConditions::registerCallbacks() {
     AlpacaDevice::registerCallbacks();
-    this->createCallBack(LHF(aGetAveragePeriod), HTTP_GET, "averageperiod");
-    this->createCallBack(LHF(aPutAveragePeriod), HTTP_PUT, "averageperiod");
-    this->createCallBack(LHF(aGetDewPoint), HTTP_GET, "dewpoint");
-    this->createCallBack(LHF(aGetHumidity), HTTP_GET, "humidity");
-    this->createCallBack(LHF(aGetPressure), HTTP_GET, "pressure");
-    this->createCallBack(LHF(aGetRainRate), HTTP_GET, "rainrate");
-    this->createCallBack(LHF(aGetSkyBrightness), HTTP_GET, "skybrightness");
-    this->createCallBack(LHF(aGetSkyQuality), HTTP_GET, "skyquality");
-    this->createCallBack(LHF(aGetSkyTemperature), HTTP_GET, "skytemperature");
-    this->createCallBack(LHF(aGetStarFwhm), HTTP_GET, "starfwhm");
-    this->createCallBack(LHF(aGetTemperature), HTTP_GET, "temperature");
-    this->createCallBack(LHF(aGetWindDirection), HTTP_GET, "winddirection");
-    this->createCallBack(LHF(aGetWindGust), HTTP_GET, "windgust");
-    this->createCallBack(LHF(aGetWindSpeed), HTTP_GET, "windspeed");
-    this->createCallBack(LHF(aPutRefresh), HTTP_PUT, "refresh");
-    this->createCallBack(LHF(aGetSensorDescription), HTTP_GET, "sensordescription");
-    this->createCallBack(LHF(aGetTimeSinceLastUpdate), HTTP_GET, "timesincelastupdate");
-    this->createCallBack(LHF(aGetCloudCover), HTTP_GET, "cloudcover");
+    static const AlpacaBinding commands[] = {
+        ALPACA_DEFAULT(AlpacaObservingConditions, "averageperiod", HTTP_GET, aGetAveragePeriod),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "averageperiod", HTTP_PUT, aPutAveragePeriod),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "dewpoint", HTTP_GET, aGetDewPoint),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "humidity", HTTP_GET, aGetHumidity),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "pressure", HTTP_GET, aGetPressure),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "rainrate", HTTP_GET, aGetRainRate),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "skybrightness", HTTP_GET, aGetSkyBrightness),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "skyquality", HTTP_GET, aGetSkyQuality),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "skytemperature", HTTP_GET, aGetSkyTemperature),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "starfwhm", HTTP_GET, aGetStarFwhm),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "temperature", HTTP_GET, aGetTemperature),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "winddirection", HTTP_GET, aGetWindDirection),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "windgust", HTTP_GET, aGetWindGust),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "windspeed", HTTP_GET, aGetWindSpeed),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "refresh", HTTP_PUT, aPutRefresh),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "sensordescription", HTTP_GET, aGetSensorDescription),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "timesincelastupdate", HTTP_GET, aGetTimeSinceLastUpdate),
+        ALPACA_DEFAULT(AlpacaObservingConditions, "cloudcover", HTTP_GET, aGetCloudCover),
+    };
+    bind(commands);
+    this->createCallBack(LHF(_getHistory), HTTP_GET, "history", false);
+}
+
+void AlpacaObservingConditions::beginDeferred() {
+    AlpacaDevice::beginDeferred();
+    char name[32];
+    snprintf(name, sizeof(name), "%s%d", _device_type, _device_number);
+    _history.begin(_alpacaServer, name);
+}
+
+// return min/max/mean buckets for one channel, times in epoch seconds
+void AlpacaObservingConditions::_getHistory(AsyncWebServerRequest *request) {
+    char channel_name[32] = "temperature";
+    int from = 0;
+    int to = 0;
+    int resolution = 0;
+    _alpacaServer->getParam(request, "Channel", channel_name, sizeof(channel_name));
+    _alpacaServer->getParam(request, "From", from);
+    _alpacaServer->getParam(request, "To", to);
+    _alpacaServer->getParam(request, "Resolution", resolution);
+
+    int channel = AlpacaHistory::channelFromName(channel_name);
+    if (channel < 0) {
+        _alpacaServer->respond(request, nullptr, InvalidValue, "Unknown history channel");
+        return;
+    }
+    if (to <= 0)
+        to = time(nullptr);
+    if (from <= 0)
+        from = to - 86400;
+
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root[F("Channel")] = AlpacaHistory::channelName(channel);
+    root[F("From")] = from;
+    root[F("To")] = to;
+    JsonArray buckets = root[F("Buckets")].to<JsonArray>();
+    root[F("Resolution")] = _history.query((AlpacaHistoryChannel)channel, from, to, resolution, buckets);
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    _alpacaServer->sendJson(request, ser_json);
 }
 
 void AlpacaObservingConditions::aGetInterfaceVersion(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, ALPACA_OBSERVINGCONDITIONS_INTERFACE_VERSION);
 };
+
+void AlpacaObservingConditions::aGetAveragePeriod(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aPutAveragePeriod(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetDewPoint(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetHumidity(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetPressure(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetRainRate(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetSkyBrightness(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetSkyTemperature(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetSkyQuality(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetStarFwhm(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetTemperature(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetWindDirection(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetWindGust(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetWindSpeed(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aPutRefresh(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetSensorDescription(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetTimeSinceLastUpdate(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
+void AlpacaObservingConditions::aGetCloudCover(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
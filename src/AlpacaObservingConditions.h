@@ -1,32 +1,38 @@
 #pragma once
 #include "AlpacaDevice.h"
+#include "AlpacaHistory.h"
 
 #define ALPACA_OBSERVINGCONDITIONS_INTERFACE_VERSION "3"
 
 class AlpacaObservingConditions : public AlpacaDevice {
   protected:
-    // alpaca commands
+    // sensor history, drivers feed it with _history.record()
+    AlpacaHistory _history;
+    void _getHistory(AsyncWebServerRequest *request);
+
+    // alpaca commands, defaults answer NotImplemented
     void aGetInterfaceVersion(AsyncWebServerRequest *request);
-    virtual void aGetAveragePeriod(AsyncWebServerRequest *request) = 0;
-    virtual void aPutAveragePeriod(AsyncWebServerRequest *request) = 0;
-    virtual void aGetDewPoint(AsyncWebServerRequest *request) = 0;
-    virtual void aGetHumidity(AsyncWebServerRequest *request) = 0;
-    virtual void aGetPressure(AsyncWebServerRequest *request) = 0;
-    virtual void aGetRainRate(AsyncWebServerRequest *request) = 0;
-    virtual void aGetSkyBrightness(AsyncWebServerRequest *request) = 0;
-    virtual void aGetSkyTemperature(AsyncWebServerRequest *request) = 0;
-    virtual void aGetSkyQuality(AsyncWebServerRequest *request) = 0;
-    virtual void aGetStarFwhm(AsyncWebServerRequest *request) = 0;
-    virtual void aGetTemperature(AsyncWebServerRequest *request) = 0;
-    virtual void aGetWindDirection(AsyncWebServerRequest *request) = 0;
-    virtual void aGetWindGust(AsyncWebServerRequest *request) = 0;
-    virtual void aGetWindSpeed(AsyncWebServerRequest *request) = 0;
-    virtual void aPutRefresh(AsyncWebServerRequest *request) = 0;
-    virtual void aGetSensorDescription(AsyncWebServerRequest *request) = 0;
-    virtual void aGetTimeSinceLastUpdate(AsyncWebServerRequest *request) = 0;
-    virtual void aGetCloudCover(AsyncWebServerRequest *request) = 0;
+    virtual void aGetAveragePeriod(AsyncWebServerRequest *request);
+    virtual void aPutAveragePeriod(AsyncWebServerRequest *request);
+    virtual void aGetDewPoint(AsyncWebServerRequest *request);
+    virtual void aGetHumidity(AsyncWebServerRequest *request);
+    virtual void aGetPressure(AsyncWebServerRequest *request);
+    virtual void aGetRainRate(AsyncWebServerRequest *request);
+    virtual void aGetSkyBrightness(AsyncWebServerRequest *request);
+    virtual void aGetSkyTemperature(AsyncWebServerRequest *request);
+    virtual void aGetSkyQuality(AsyncWebServerRequest *request);
+    virtual void aGetStarFwhm(AsyncWebServerRequest *request);
+    virtual void aGetTemperature(AsyncWebServerRequest *request);
+    virtual void aGetWindDirection(AsyncWebServerRequest *request);
+    virtual void aGetWindGust(AsyncWebServerRequest *request);
+    virtual void aGetWindSpeed(AsyncWebServerRequest *request);
+    virtual void aPutRefresh(AsyncWebServerRequest *request);
+    virtual void aGetSensorDescription(AsyncWebServerRequest *request);
+    virtual void aGetTimeSinceLastUpdate(AsyncWebServerRequest *request);
+    virtual void aGetCloudCover(AsyncWebServerRequest *request);
     AlpacaObservingConditions() { strcpy(_device_type, "observingconditions"); }
 
   public:
     void registerCallbacks();
+    void beginDeferred();
 };
\ No newline at end of file
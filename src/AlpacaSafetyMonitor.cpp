@@ -2,9 +2,16 @@
 
 void AlpacaSafetyMonitor::registerCallbacks() {
     AlpacaDevice::registerCallbacks();
-    this->createCallBack(LHF(aGetIsSafe), HTTP_GET, "issafe");
+    static const AlpacaBinding commands[] = {
+        ALPACA_DEFAULT(AlpacaSafetyMonitor, "issafe", HTTP_GET, aGetIsSafe),
+    };
+    bind(commands);
 }
 
 void AlpacaSafetyMonitor::aGetInterfaceVersion(AsyncWebServerRequest *request) {
     _alpacaServer->respond(request, ALPACA_SAFETYMONITOR_INTERFACE_VERSION);
 };
+
+void AlpacaSafetyMonitor::aGetIsSafe(AsyncWebServerRequest *request) {
+    _alpacaServer->respond(request, nullptr, NotImplemented);
+};
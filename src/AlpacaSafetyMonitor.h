@@ -5,9 +5,9 @@
 
 class AlpacaSafetyMonitor : public AlpacaDevice {
   protected:
-    // alpaca commands
+    // alpaca commands, defaults answer NotImplemented
     void aGetInterfaceVersion(AsyncWebServerRequest *request);
-    virtual void aGetIsSafe(AsyncWebServerRequest *request) = 0;
+    virtual void aGetIsSafe(AsyncWebServerRequest *request);
     AlpacaSafetyMonitor() { strcpy(_device_type, "safetymonitor"); }
 
   public:
@@ -0,0 +1,180 @@
+#include "AlpacaScheduler.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+static_assert(ALPACA_BUS_MAX_JOBS <= 32, "jobs run in a poll are a 32 bit mask");
+
+// signed difference of two wrapping microsecond timestamps, valid within ALPACA_BUS_MAX_PERIOD_MS
+#define BUS_DIFF(a, b) ((int32_t)((a) - (b)))
+
+// bus time accounting
+static uint32_t busMicros() {
+#ifdef ARDUINO
+    return micros();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// declare a periodic transaction, call before begin(), returns -1 if the job is invalid or the table full
+// period_ms is 1 to ALPACA_BUS_MAX_PERIOD_MS, the conversion has to end within the period
+int AlpacaScheduler::addJob(const char *name, uint8_t address, const uint8_t *command, uint8_t command_len, uint8_t read_len,
+                            uint32_t period_ms, AlpacaBusCallback callback, uint32_t conversion_us) {
+    if (_n_jobs == ALPACA_BUS_MAX_JOBS || command_len > ALPACA_BUS_MAX_COMMAND || read_len > ALPACA_BUS_MAX_READ)
+        return -1;
+    if (period_ms == 0 || period_ms > ALPACA_BUS_MAX_PERIOD_MS || conversion_us >= period_ms * 1000)
+        return -1;
+    AlpacaBusJob &job = _job[_n_jobs];
+    memset(&job.command, 0, sizeof(job.command));
+    job.name = name;
+    job.address = address;
+    if (command_len)
+        memcpy(job.command, command, command_len);
+    job.commandLen = command_len;
+    job.readLen = read_len;
+    job.periodUs = period_ms * 1000;
+    job.conversionUs = conversion_us;
+    job.callback = callback;
+    job.started = false;
+    job.due = 0;
+    job.readAt = 0;
+    job.pending = false;
+    job.runs = 0;
+    job.overruns = 0;
+    job.errors = 0;
+    job.jitterMax = 0;
+    job.jitterSum = 0;
+    return _n_jobs++;
+}
+
+#ifdef ARDUINO
+void AlpacaScheduler::begin(UBaseType_t priority, BaseType_t core) {
+    xTaskCreatePinnedToCore(_run, "alpacabus", 4096, this, priority, &_task, core);
+}
+
+void AlpacaScheduler::_run(void *arg) {
+    AlpacaScheduler *scheduler = (AlpacaScheduler *)arg;
+    while (true) {
+        uint32_t wait = scheduler->poll(micros());
+        vTaskDelay(max((uint32_t)1, (uint32_t)pdMS_TO_TICKS(wait / 1000)));
+    }
+}
+#endif
+
+// read the result of a job whose conversion time has passed
+void AlpacaScheduler::_finish(AlpacaBusJob &job) {
+    uint8_t data[ALPACA_BUS_MAX_READ];
+    uint32_t start = busMicros();
+    bool ok = _bus->transfer(job.address, nullptr, 0, data, job.readLen);
+    _busyUs += busMicros() - start;
+    job.pending = false;
+    if (!ok)
+        job.errors++;
+    if (job.callback)
+        job.callback(ok, data, job.readLen);
+}
+
+// issue the command of a due job, reading at once if there is no conversion time
+void AlpacaScheduler::_start(AlpacaBusJob &job, uint32_t now) {
+    uint32_t jitter = abs(BUS_DIFF(now, job.due));
+    job.jitterMax = std::max(job.jitterMax, jitter);
+    job.jitterSum += jitter;
+    job.runs++;
+
+    // keep the phase, every period that was missed is an overrun
+    job.due += job.periodUs;
+    if (BUS_DIFF(job.due, now) <= 0) {
+        uint32_t missed = (now - job.due) / job.periodUs + 1;
+        job.due += missed * job.periodUs;
+        job.overruns += missed;
+    }
+
+    uint8_t data[ALPACA_BUS_MAX_READ];
+    uint32_t start = busMicros();
+    if (job.conversionUs == 0) {
+        bool ok = _bus->transfer(job.address, job.command, job.commandLen, data, job.readLen);
+        _busyUs += busMicros() - start;
+        if (!ok)
+            job.errors++;
+        if (job.callback)
+            job.callback(ok, data, job.readLen);
+        return;
+    }
+    bool ok = _bus->transfer(job.address, job.command, job.commandLen, nullptr, 0);
+    _busyUs += busMicros() - start;
+    if (!ok) {
+        job.errors++;
+        if (job.callback)
+            job.callback(false, data, 0);
+        return;
+    }
+    // the conversion starts when the command went out, after the transfers earlier in this burst
+    job.pending = true;
+    job.readAt = now + (busMicros() - _pollStart) + job.conversionUs;
+}
+
+// run everything due at now, returns microseconds until the next job or read is due
+uint32_t AlpacaScheduler::poll(uint32_t now) {
+    // jobs started in this call, a period shorter than the burst window must not run twice
+    uint32_t started = 0;
+    _pollStart = busMicros();
+    while (true) {
+        // earliest pending read or due job, lower address first on ties
+        AlpacaBusJob *next = nullptr;
+        int next_index = 0;
+        uint32_t next_at = 0;
+        int32_t later = ALPACA_BUS_IDLE_US;
+        for (int i = 0; i < _n_jobs; i++) {
+            AlpacaBusJob &job = _job[i];
+            if (!job.started) {
+                job.started = true;
+                job.due = now;
+            }
+            uint32_t at = job.pending ? job.readAt : job.due;
+            if (!job.pending && (started & (1u << i))) {
+                later = std::min(later, std::max((int32_t)1, BUS_DIFF(at, now)));
+                continue;
+            }
+            if (next == nullptr || BUS_DIFF(at, next_at) < 0 || (at == next_at && job.address < next->address)) {
+                next = &job;
+                next_index = i;
+                next_at = at;
+            }
+        }
+        if (next == nullptr)
+            return later;
+        int32_t wait = BUS_DIFF(next_at, now);
+        // a read has to wait for the conversion, a job may be pulled in to join the burst
+        if (wait > (next->pending ? 0 : ALPACA_BUS_COALESCE_US))
+            return std::min(wait, later);
+        if (next->pending) {
+            _finish(*next);
+        } else {
+            _start(*next, now);
+            started |= 1u << next_index;
+        }
+    }
+}
+
+#ifdef ARDUINO
+void AlpacaScheduler::writeStats(JsonObject root) {
+    root[F("BusyUs")] = _busyUs;
+    JsonArray jobs = root[F("Jobs")].to<JsonArray>();
+    for (int i = 0; i < _n_jobs; i++) {
+        AlpacaBusJob &job = _job[i];
+        JsonObject obj = jobs.add<JsonObject>();
+        obj[F("Name")] = job.name;
+        obj[F("Address")] = job.address;
+        obj[F("PeriodUs")] = job.periodUs;
+        obj[F("Runs")] = job.runs;
+        obj[F("Overruns")] = job.overruns;
+        obj[F("Errors")] = job.errors;
+        obj[F("JitterMaxUs")] = job.jitterMax;
+        obj[F("JitterMeanUs")] = job.runs ? (uint32_t)(job.jitterSum / job.runs) : 0;
+    }
+}
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+#include <functional>
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#endif
+#include "AlpacaBus.h"
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_BUS_MAX_JOBS
+#define ALPACA_BUS_MAX_JOBS 16
+#endif
+#ifndef ALPACA_BUS_COALESCE_US
+#define ALPACA_BUS_COALESCE_US 2000 // jobs due within this window run in the same burst
+#endif
+#define ALPACA_BUS_MAX_COMMAND 4
+#define ALPACA_BUS_MAX_READ 16
+#define ALPACA_BUS_MAX_PERIOD_MS 1800000 // timestamps wrap after 71 min, differences stay signed below 35 min
+#define ALPACA_BUS_IDLE_US 1000000
+
+// called on the scheduler task with the bytes read, store them in the device's cached state
+typedef std::function<void(bool ok, const uint8_t *data, size_t len)> AlpacaBusCallback;
+
+typedef struct {
+    const char *name;
+    uint8_t address;
+    uint8_t command[ALPACA_BUS_MAX_COMMAND];
+    uint8_t commandLen;
+    uint8_t readLen;
+    uint32_t periodUs;
+    uint32_t conversionUs; // wait between command and read, other jobs use the bus meanwhile
+    AlpacaBusCallback callback;
+    // state
+    bool started; // due is set on the first poll
+    uint32_t due;
+    uint32_t readAt;
+    bool pending;
+    // statistics
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t errors;
+    uint32_t jitterMax;
+    uint64_t jitterSum;
+} AlpacaBusJob;
+
+// Shared bus acquisition scheduler.
+// Drivers declare periodic transactions, the scheduler runs them in due order on one task,
+// bursts jobs that are due close together and fills conversion time with other jobs.
+// Without ARDUINO only addJob() and poll() are built, for host tests with AlpacaSimBus.h.
+class AlpacaScheduler {
+  private:
+    AlpacaBus *_bus;
+    AlpacaBusJob _job[ALPACA_BUS_MAX_JOBS];
+    int _n_jobs = 0;
+    uint32_t _busyUs = 0;
+    uint32_t _pollStart = 0; // bus clock when poll() was entered, its now may be behind by earlier transfers
+#ifdef ARDUINO
+    TaskHandle_t _task = nullptr;
+
+    static void _run(void *arg);
+#endif
+    void _finish(AlpacaBusJob &job);
+    void _start(AlpacaBusJob &job, uint32_t now);
+
+  public:
+    AlpacaScheduler(AlpacaBus *bus) : _bus(bus) {}
+    int addJob(const char *name, uint8_t address, const uint8_t *command, uint8_t command_len, uint8_t read_len,
+               uint32_t period_ms, AlpacaBusCallback callback, uint32_t conversion_us = 0);
+    uint32_t poll(uint32_t now);
+    const AlpacaBusJob *job(int index) { return (index >= 0 && index < _n_jobs) ? &_job[index] : nullptr; }
+#ifdef ARDUINO
+    void begin(UBaseType_t priority = 2, BaseType_t core = tskNO_AFFINITY);
+    void writeStats(JsonObject root);
+#endif
+};
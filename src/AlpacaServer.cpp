@@ -3,56 +3,48 @@
 
 #define SETTINGS_FILE "/settings.json"
 
-AlpacaServer::AlpacaServer(const char *name, const char *version, const char *build_date) {
+AlpacaServer::AlpacaServer(const char *name, const char *version, const char *build_date)
+    : _config([name](AlpacaServerConfig &config) { strlcpy(config.name, name, sizeof(config.name)); }) {
     // Get unique ID from wifi macadr.
     uint8_t mac_adr[6];
     esp_read_mac(mac_adr, ESP_MAC_WIFI_STA);
     sprintf(_uid, "%02X%02X%02X%02X%02X%02X", mac_adr[0], mac_adr[1], mac_adr[2], mac_adr[3], mac_adr[4], mac_adr[5]);
 
-    // save name
-    strcpy(_name, name);
     strcpy(_version, version);
     strcpy(_build_date, build_date);
 }
 
-// initialize alpaca server
+// initialize alpaca server, all routes and discovery first, LittleFS and settings are deferred to update()
 void AlpacaServer::begin(uint16_t udp_port, uint16_t tcp_port) {
-    // Setup filesystem
-    if (!LittleFS.begin()) {
-        Serial.println(F("[ALPACA] Error mounting LittleFS!"));
-    }
-
     // setup ports
-    _portUDP = udp_port;
-    _portTCP = tcp_port;
-
-    logMessage("[ALPACA] Ascom Alpaca discovery port (UDP): " + String(_portUDP));
-    _serverUDP.listen(_portUDP);
-    _serverUDP.onPacket([this](AsyncUDPPacket &udpPacket) { this->onAlpacaDiscovery(udpPacket); });
-
-    logMessage("[ALPACA] Ascom Alpaca server port (TCP): " + String(_portTCP));
-    _serverTCP = new AsyncWebServer(_portTCP);
-    _serverTCP->begin();
+    _config.update([tcp_port](AlpacaServerConfig &config) { config.portTCP = tcp_port; });
 
+    int phase = _bootBegin("tcp");
+    logMessage("[ALPACA] Ascom Alpaca server port (TCP): " + String(tcp_port));
+    _serverTCP = new AsyncWebServer(tcp_port);
     _serverTCP->onNotFound([this](AsyncWebServerRequest *request) {
         String url = request->url();
         request->send(400, "text/plain", "Not found: '" + url + "'");
     });
-
     _registerCallbacks();
+    _serverTCP->begin();
+    _bootEnd(phase);
+
+    phase = _bootBegin("setup");
+    _registerSetupCallbacks();
+    _bootEnd(phase);
+
+    beginUdp(udp_port);
+    _startDeferred();
 }
 
 // initialize alpaca tcp server
 void AlpacaServer::beginTcp(AsyncWebServer *tcp_server, uint16_t tcp_port) {
-    // Setup filesystem
-    if (!LittleFS.begin()) {
-        logMessage(F("[ALPACA] Error mounting LittleFS!"));
-    }
-
     // setup ports
-    _portTCP = tcp_port;
+    _config.update([tcp_port](AlpacaServerConfig &config) { config.portTCP = tcp_port; });
 
-    logMessage("[ALPACA] Ascom Alpaca server port (TCP): " + String(_portTCP));
+    int phase = _bootBegin("tcp");
+    logMessage("[ALPACA] Ascom Alpaca server port (TCP): " + String(tcp_port));
     _serverTCP = tcp_server;
     _serverTCP->onNotFound([this](AsyncWebServerRequest *request) {
         String url = request->url();
@@ -60,16 +52,130 @@ void AlpacaServer::beginTcp(AsyncWebServer *tcp_server, uint16_t tcp_port) {
     });
 
     _registerCallbacks();
+    _bootEnd(phase);
+
+    phase = _bootBegin("setup");
+    _registerSetupCallbacks();
+    _bootEnd(phase);
+    _startDeferred();
+}
+
+// move setup ui, static assets and settings to a second listener
+// bandwidth in bytes per second caps static transfers, 0 = unlimited
+void AlpacaServer::beginSetup(uint16_t port, uint8_t max_connections, uint32_t bandwidth) {
+    _portSetup = port;
+    _setupLimits.maxConnections = max_connections;
+    _setupLimits.bandwidth = bandwidth;
+    logMessage("[ALPACA] Setup server port (TCP): " + String(port));
+    _serverSetup = new AsyncWebServer(port);
+    _serverSetup->onNotFound([this](AsyncWebServerRequest *request) {
+        String url = request->url();
+        request->send(400, "text/plain", "Not found: '" + url + "'");
+    });
+    // called after begin(), move the setup handlers of the server and the devices off the api listener,
+    // removeHandler() deletes them so they are registered again
+    if (_n_setupHandlers > 0) {
+        for (int i = 0; i < _n_setupHandlers; i++)
+            _serverTCP->removeHandler(_setupHandler[i]);
+        _n_setupHandlers = 0;
+        _registerSetupCallbacks();
+        for (int i = 0; i < _n_devices; i++)
+            _device[i]->registerSetupCallbacks();
+    }
+    _serverSetup->begin();
 }
 
 // initialize alpaca udp server
 void AlpacaServer::beginUdp(uint16_t udp_port) {
     // setup ports
-    _portUDP = udp_port;
+    _config.update([udp_port](AlpacaServerConfig &config) { config.portUDP = udp_port; });
 
-    logMessage("[ALPACA] Ascom Alpaca discovery port (UDP): " + String(_portUDP));
-    _serverUDP.listen(_portUDP);
+    int phase = _bootBegin("discovery");
+    logMessage("[ALPACA] Ascom Alpaca discovery port (UDP): " + String(udp_port));
+    _serverUDP.listen(udp_port);
     _serverUDP.onPacket([this](AsyncUDPPacket &udpPacket) { this->onAlpacaDiscovery(udpPacket); });
+    _bootEnd(phase);
+    _bootReady = micros();
+}
+
+// optional binary protocol for local pollers, see AlpacaBinary.h
+void AlpacaServer::beginBinary(uint16_t port) {
+    int phase = _bootBegin("binary");
+    logMessage("[ALPACA] Binary protocol port (UDP): " + String(port));
+    _serverBinary.listen(port);
+    _serverBinary.onPacket([this](AsyncUDPPacket &udpPacket) { this->onBinary(udpPacket); });
+    _bootEnd(phase);
+}
+
+// run deferred initialization, call from loop()
+void AlpacaServer::update() {
+    _beginDeferred();
+}
+
+// sketches that don't call update() get the deferred initialization from a one-shot task
+void AlpacaServer::_startDeferred() {
+    if (_deferredLock != nullptr)
+        return;
+    _deferredLock = xSemaphoreCreateMutex();
+    xTaskCreate(_deferredTask, "alpacaboot", 8192, this, 1, nullptr);
+}
+
+void AlpacaServer::_deferredTask(void *arg) {
+    vTaskDelay(pdMS_TO_TICKS(ALPACA_DEFER_TIMEOUT));
+    ((AlpacaServer *)arg)->_beginDeferred();
+    vTaskDelete(nullptr);
+}
+
+void AlpacaServer::_lockDeferred() {
+    if (_deferredLock)
+        xSemaphoreTake(_deferredLock, portMAX_DELAY);
+}
+
+void AlpacaServer::_unlockDeferred() {
+    if (_deferredLock)
+        xSemaphoreGive(_deferredLock);
+}
+
+// mount LittleFS, start the devices' deferred parts and load pending settings once the api is answering
+void AlpacaServer::_beginDeferred() {
+    if (_deferredDone)
+        return;
+    _lockDeferred();
+    if (!_deferredDone) {
+        int phase = _bootBegin("littlefs");
+        if (!LittleFS.begin()) {
+            logMessage(F("[ALPACA] Error mounting LittleFS!"));
+        }
+        _bootEnd(phase);
+
+        for (int i = 0; i < _n_devices; i++) {
+            phase = _bootBegin("deviceflash", i);
+            _device[i]->beginDeferred();
+            _bootEnd(phase);
+        }
+        _deferredDone = true;
+        if (_settingsPending) {
+            _settingsPending = false;
+            _loadSettings();
+        }
+    }
+    _unlockDeferred();
+}
+
+int AlpacaServer::_bootBegin(const char *name, int8_t device) {
+    if (_n_bootPhases == ALPACA_BOOT_PHASES)
+        return -1;
+    AlpacaBootPhase &phase = _bootPhase[_n_bootPhases];
+    phase.name = name;
+    phase.device = device;
+    phase.start = micros();
+    phase.duration = 0;
+    return _n_bootPhases++;
+}
+
+void AlpacaServer::_bootEnd(int phase) {
+    if (phase >= 0)
+        _bootPhase[phase].duration = micros() - _bootPhase[phase].start;
 }
 
 // add alpaca device to server
@@ -89,38 +195,65 @@ void AlpacaServer::addDevice(AlpacaDevice *device) {
         }
     }
     // and set device number
+    _lockDeferred();
+    int phase = _bootBegin("device", _n_devices);
     _device[_n_devices++] = device;
     device->setAlpacaServer(this);
     device->setDeviceNumber(device_number);
     device->registerCallbacks();
+    if (_deferredDone)
+        device->beginDeferred();
+    _bootEnd(phase);
+    _bootReady = micros();
+    _unlockDeferred();
 }
 
 // register callbacks for REST API
 void AlpacaServer::_registerCallbacks() {
     // setup rest api
     logMessage(F("[ALPACA] Register handler for \"/management/apiversions\" to getApiVersions"));
-    _serverTCP->on("/management/apiversions", HTTP_GET, LHF(_getApiVersions));
+    on("/management/apiversions", HTTP_GET, LHF(_getApiVersions));
     logMessage(F("[ALPACA] Register handler for \"/management/v1/description\" to getDescription"));
-    _serverTCP->on("/management/v1/description", HTTP_GET, LHF(_getDescription));
+    on("/management/v1/description", HTTP_GET, LHF(_getDescription));
     logMessage(F("[ALPACA] Register handler for \"/management/v1/configureddevices\" to getConfiguredDevices"));
-    _serverTCP->on("/management/v1/configureddevices", HTTP_GET, LHF(_getConfiguredDevices));
+    on("/management/v1/configureddevices", HTTP_GET, LHF(_getConfiguredDevices));
+    _serverTCP->on("/boottimeline", HTTP_GET, LHF(_getBootTimeline));
+    _serverTCP->on("/compression", HTTP_GET, LHF(_getCompression));
+    _serverTCP->on("/scheduler", HTTP_GET, LHF(_getScheduler));
+    _serverTCP->on("/trace", HTTP_GET, LHF(_getTrace));
+    _serverTCP->on("/sessions", HTTP_GET, LHF(_getSessions));
+    _serverTCP->on("/binary", HTTP_GET, LHF(_getBinary));
+}
+
+void AlpacaServer::_addSetupHandler(AsyncWebHandler *handler) {
+    if (_n_setupHandlers < ALPACA_SETUP_HANDLERS)
+        _setupHandler[_n_setupHandlers++] = handler;
+    else
+        logMessage(F("[ALPACA] ERROR - max setup handlers exceeded"));
+}
+
+// register callbacks for setup webpages, files are served once LittleFS is mounted
+void AlpacaServer::_registerSetupCallbacks() {
+    AsyncWebServer *server = getServerSetup();
 
     // setup webpages
-    _serverTCP->serveStatic("/setup", LittleFS, "/www/setup.html");
-    _serverTCP->serveStatic(SETTINGS_FILE, LittleFS, SETTINGS_FILE);
-    _serverTCP->serveStatic("/js", LittleFS, "/www/js/").setCacheControl("max-age=3600");
-    _serverTCP->serveStatic("/css", LittleFS, "/www/css/").setCacheControl("max-age=3600");
+    serveSetup("/setup", "/www/setup.html");
+    serveSetup(SETTINGS_FILE, SETTINGS_FILE);
+    serveSetup("/js", "/www/js/").setCacheControl("max-age=3600");
+    serveSetup("/css", "/www/css/").setCacheControl("max-age=3600");
 
     logMessage(F("[ALPACA] Register handler for \"/jsondata\" to readJson"));
-    _serverTCP->on("/jsondata", HTTP_GET, LHF(_getJsondata));
-    _serverTCP->on("/links", HTTP_GET, LHF(_getLinks));
+    onSetup("/jsondata", HTTP_GET, LHF(_getJsondata));
+    onSetup("/links", HTTP_GET, LHF(_getLinks));
+    if (server != _serverTCP)
+        _serverTCP->on("/links", HTTP_GET, LHF(_getLinks));
     AsyncCallbackJsonWebHandler *jsonhandler = new AsyncCallbackJsonWebHandler("/jsondata", [this](AsyncWebServerRequest *request, JsonVariant &json) {
         JsonObject jsonObj = json.as<JsonObject>();
         this->_readJson(jsonObj);
         request->send(200, F("application/json"), F("{\"recieved\":\"true\"}"));
     });
-    _serverTCP->addHandler(jsonhandler);
-    _serverTCP->on("/save_settings", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    addSetupHandler(jsonhandler);
+    onSetup("/save_settings", HTTP_GET, [this](AsyncWebServerRequest *request) {
         if (this->saveSettings())
             request->send(200, "application/json", F("{\"saved\":true}"));
         else
@@ -128,6 +261,100 @@ void AlpacaServer::_registerCallbacks() {
     });
 }
 
+// serve a setup ui file, throttled by the setup listener's limits
+AlpacaStaticHandler &AlpacaServer::serveSetup(const char *uri, const char *path) {
+    AlpacaStaticHandler *handler = new AlpacaStaticHandler(uri, path, &_setupLimits);
+    addSetupHandler(handler);
+    return *handler;
+}
+
+// register a setup ui handler, tracked so a later beginSetup() moves it to the setup listener
+AsyncCallbackWebHandler &AlpacaServer::onSetup(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction fn) {
+    AsyncCallbackWebHandler &handler = getServerSetup()->on(uri, method, fn);
+    _addSetupHandler(&handler);
+    return handler;
+}
+
+AsyncWebHandler &AlpacaServer::addSetupHandler(AsyncWebHandler *handler) {
+    getServerSetup()->addHandler(handler);
+    _addSetupHandler(handler);
+    return *handler;
+}
+
+// register alpaca api handler, wrapped for sessions and the request trace
+AsyncCallbackWebHandler &AlpacaServer::on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction fn) {
+    return _serverTCP->on(uri, method, [this, fn](AsyncWebServerRequest *request) {
+        uint32_t start = requestBegin(request);
+        fn(request);
+        requestEnd(request, start);
+    });
+}
+
+// account every api request, returns the start time for requestEnd()
+uint32_t AlpacaServer::requestBegin(AsyncWebServerRequest *request) {
+    _sessions.open(request, _clientId(request));
+    uint32_t changed = _sessions.changed();
+    if (changed)
+        _syncConnected(changed);
+    _traceBytes = 0;
+    return _trace.enabled() ? micros() : 0;
+}
+
+void AlpacaServer::requestEnd(AsyncWebServerRequest *request, uint32_t start) {
+    if (!_trace.enabled())
+        return;
+    uint32_t duration = micros() - start;
+    char params[ALPACA_TRACE_PARAMS + 1];
+    size_t len = 0;
+    bool truncated = false;
+    for (size_t i = 0; i < request->args(); i++) {
+        // differs on every request and is not needed to replay it
+        if (request->argName(i).equalsIgnoreCase("clienttransactionid"))
+            continue;
+        // snprintf returns the untruncated length, stop at the terminator
+        size_t n = snprintf(params + len, sizeof(params) - len, "%s%s=%s", len ? "&" : "", request->argName(i).c_str(), request->arg(i).c_str());
+        if (len + n >= sizeof(params)) {
+            len = sizeof(params) - 1;
+            truncated = true;
+            break;
+        }
+        len += n;
+    }
+    char method = (request->method() == HTTP_PUT) ? 'P' : (request->method() == HTTP_GET) ? 'G' : 'O';
+    uint32_t route = _trace.route(method, request->url());
+    _trace.record(route, start, duration, (uint32_t)request->client()->remoteIP(), _traceBytes, params, len, truncated);
+}
+
+// captured requests as binary, or saved to LittleFS with ?save
+void AlpacaServer::_getTrace(AsyncWebServerRequest *request) {
+    if (!_trace.enabled()) {
+        request->send(404, "text/plain", "Trace not enabled");
+        return;
+    }
+    if (_paramIndex(request, "save") >= 0) {
+        if (saveTrace())
+            request->send(200, "application/json", F("{\"saved\":true}"));
+        else
+            request->send(400, "application/json", F("{\"saved\":false}"));
+        return;
+    }
+    AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+    _trace.write(*response);
+    request->send(response);
+}
+
+bool AlpacaServer::saveTrace(const char *path) {
+    _beginDeferred();
+    File file = LittleFS.open(path, FILE_WRITE);
+    if (!file) {
+        logMessage(F("[ALPACA] LittleFS could not create trace file"));
+        return false;
+    }
+    size_t size = _trace.write(file);
+    file.close();
+    return size > 0;
+}
+
 void AlpacaServer::_getApiVersions(AsyncWebServerRequest *request) {
     respond(request, ALPACA_API_VERSIONS);
 }
@@ -143,10 +370,11 @@ void AlpacaServer::_getConfiguredDevices(AsyncWebServerRequest *request) {
     char deviceinfo[256];
     strcat(value, "[");
     for (int i = 0; i < _n_devices; i++) {
+        auto config = _device[i]->readConfig();
         sprintf(
             deviceinfo,
             ALPACA_DEVICE_LIST,
-            _device[i]->getDeviceName(),
+            config->name,
             _device[i]->getDeviceType(),
             _device[i]->getDeviceNumber(),
             _device[i]->getDeviceUID());
@@ -160,6 +388,8 @@ void AlpacaServer::_getConfiguredDevices(AsyncWebServerRequest *request) {
 
 // return index of parameter 'name' in PUT request, return -1 if not found
 int AlpacaServer::_paramIndex(AsyncWebServerRequest *request, const char *name) {
+    if (request == nullptr)
+        return -1;
     for (int i = 0; i < request->args(); i++) {
         if (request->argName(i).equalsIgnoreCase(name)) {
             return i;
@@ -208,12 +438,20 @@ bool AlpacaServer::getParam(AsyncWebServerRequest *request, const char *name, ch
 
 // send response to alpaca client with bool
 void AlpacaServer::respond(AsyncWebServerRequest *request, bool value, int32_t error_number, const char *error_message) {
+    AlpacaReading reading;
+    alpacaRead(reading, value);
+    if (_capture(request, reading, error_number))
+        return;
     const char *str_val = (value ? "true" : "false"); // bug corrected. was returning string '1'/'0' instead 'true'/'false'
     respond(request, str_val, error_number, error_message);
 }
 
 // send response to alpaca client with int
 void AlpacaServer::respond(AsyncWebServerRequest *request, int32_t value, int32_t error_number, const char *error_message) {
+    AlpacaReading reading;
+    alpacaRead(reading, value);
+    if (_capture(request, reading, error_number))
+        return;
     char str_val[16];
     sprintf(str_val, "%i", value);
     respond(request, str_val, error_number, error_message);
@@ -221,6 +459,10 @@ void AlpacaServer::respond(AsyncWebServerRequest *request, int32_t value, int32_
 
 // send response to alpaca client with float
 void AlpacaServer::respond(AsyncWebServerRequest *request, float value, int32_t error_number, const char *error_message) {
+    AlpacaReading reading;
+    alpacaRead(reading, value);
+    if (_capture(request, reading, error_number))
+        return;
     char str_val[16];
     sprintf(str_val, "%0.5f", value);
     respond(request, str_val, error_number, error_message);
@@ -252,6 +494,15 @@ String AlpacaServer::_minifyJson(String s) {
 
 // send response to alpaca client with string
 void AlpacaServer::respond(AsyncWebServerRequest *request, const char *value, int32_t error_number, const char *error_message) {
+    if (request == nullptr) {
+        AlpacaReading reading = {AlpacaNone, {false}};
+        if (value) {
+            strlcpy(_captureString, value, sizeof(_captureString));
+            alpacaRead(reading, (const char *)_captureString);
+        }
+        _capture(request, reading, error_number);
+        return;
+    }
     logMessage("[ALPACA] < " + _ipReadable(request->client()->remoteIP()) + " " + String(request->url()));
 
     // int clientID = 0;
@@ -269,20 +520,167 @@ void AlpacaServer::respond(AsyncWebServerRequest *request, const char *value, in
 
     // create msg to be sent, hope that buffer is large enough
     char response[2048];
+    int len;
 
     if (value == nullptr) {
-        sprintf(response, ALPACA_RESPONSE_ERROR, clientTransactionID, _serverTransactionID, error_number, error_message);
+        len = sprintf(response, ALPACA_RESPONSE_ERROR, clientTransactionID, _serverTransactionID, error_number, error_message);
     } else {
         if ((value[0] >= '0' && value[0] <= '9') || value[0] == '[' || value[0] == '{' || value[0] == '"' || strcmp(value, "true") == 0 || strcmp(value, "false") == 0) {
-            sprintf(response, ALPACA_RESPONSE_VALUE_ERROR, value, clientTransactionID, _serverTransactionID, error_number, error_message);
+            len = sprintf(response, ALPACA_RESPONSE_VALUE_ERROR, value, clientTransactionID, _serverTransactionID, error_number, error_message);
         } else {
-            sprintf(response, ALPACA_RESPONSE_VALUE_ERROR_STR, value, clientTransactionID, _serverTransactionID, error_number, error_message);
+            len = sprintf(response, ALPACA_RESPONSE_VALUE_ERROR_STR, value, clientTransactionID, _serverTransactionID, error_number, error_message);
         }
     }
-    request->send(200, ALPACA_JSON_TYPE, response);
+    sendJson(request, response, len);
     logMessage("[ALPACA] > " + _minifyJson(String(response)));
 }
 
+// start a binary protocol read, respond() to the null request fills reading until captureEnd()
+void AlpacaServer::captureBegin(AlpacaReading &reading) {
+    reading.type = AlpacaNone;
+    _captureReading = &reading;
+    _captureError = 0;
+    _captured = false;
+}
+
+// returns the error number the handler responded with, handlers that did not respond are not readable
+int32_t AlpacaServer::captureEnd() {
+    _captureReading = nullptr;
+    return _captured ? _captureError : AlpacaNotImplementedException;
+}
+
+bool AlpacaServer::_capture(AsyncWebServerRequest *request, const AlpacaReading &reading, int32_t error_number) {
+    if (request != nullptr)
+        return false;
+    if (_captureReading != nullptr && !_captured) {
+        *_captureReading = reading;
+        _captureError = error_number;
+        _captured = true;
+    }
+    return true;
+}
+
+bool AlpacaServer::_acceptsGzip(AsyncWebServerRequest *request) {
+    const AsyncWebHeader *header = request->getHeader("Accept-Encoding");
+    return header && header->value().indexOf("gzip") >= 0;
+}
+
+// send json body, gzip compressed if the client accepts it and the body is over ALPACA_GZIP_THRESHOLD
+void AlpacaServer::sendJson(AsyncWebServerRequest *request, const char *json, size_t len) {
+    _gzip.stats.responses++;
+    if (len >= ALPACA_GZIP_THRESHOLD && _acceptsGzip(request) && _gzip.lock()) {
+        AsyncResponseStream *response = request->beginResponseStream(ALPACA_JSON_TYPE, len / 2);
+        response->addHeader("Content-Encoding", "gzip");
+        response->addHeader("Vary", "Accept-Encoding");
+        _traceBytes = _gzip.compress((const uint8_t *)json, len, *response);
+        _gzip.unlock();
+        request->send(response);
+        return;
+    }
+    _gzip.stats.bytesIn += len;
+    _gzip.stats.bytesOut += len;
+    _traceBytes = len;
+    // exactly len bytes, copied since json is often a stack buffer of the caller
+    AsyncResponseStream *response = request->beginResponseStream(ALPACA_JSON_TYPE, len);
+    response->write((const uint8_t *)json, len);
+    request->send(response);
+}
+
+// compression counters, bytes on air against time spent compressing
+void AlpacaServer::_getCompression(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root[F("Threshold")] = ALPACA_GZIP_THRESHOLD;
+    root[F("Responses")] = _gzip.stats.responses;
+    root[F("Compressed")] = _gzip.stats.compressed;
+    root[F("BytesIn")] = _gzip.stats.bytesIn;
+    root[F("BytesOut")] = _gzip.stats.bytesOut;
+    root[F("CompressMicros")] = _gzip.stats.micros;
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    request->send(200, ALPACA_JSON_TYPE, ser_json);
+}
+
+// bus scheduler jitter and overrun statistics
+void AlpacaServer::_getScheduler(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    if (_scheduler)
+        _scheduler->writeStats(root);
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    sendJson(request, ser_json);
+}
+
+void AlpacaServer::_getSessions(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    _sessions.writeStats(root);
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    sendJson(request, ser_json);
+}
+
+void AlpacaServer::_getBinary(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    _binary.writeStats(root);
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    sendJson(request, ser_json);
+}
+
+uint32_t AlpacaServer::_clientId(AsyncWebServerRequest *request) {
+    int client_id = 0;
+    getParam(request, "ClientID", client_id);
+    return client_id;
+}
+
+int AlpacaServer::_deviceIndex(AlpacaDevice *device) {
+    for (int i = 0; i < _n_devices; i++) {
+        if (_device[i] == device)
+            return i;
+    }
+    return -1;
+}
+
+// a device stays connected while any client has it connected
+// only devices whose clients changed, drivers that keep the connected state themselves have no clients
+void AlpacaServer::_syncConnected(uint32_t devices) {
+    for (int i = 0; i < _n_devices; i++) {
+        if (devices & (1u << i))
+            _device[i]->setConnected(_sessions.connected(i));
+    }
+}
+
+// set the connected state of the requesting client, returns the state of the device
+bool AlpacaServer::connectDevice(AsyncWebServerRequest *request, AlpacaDevice *device, bool connected) {
+    int index = _deviceIndex(device);
+    AlpacaSession *session = _sessions.get(request, _clientId(request));
+    if (index < 0 || session == nullptr)
+        return connected;
+    return _sessions.connect(session, index, connected);
+}
+
+// connected state as seen by the requesting client
+bool AlpacaServer::isConnected(AsyncWebServerRequest *request, AlpacaDevice *device) {
+    if (request == nullptr)
+        return device->isConnected();
+    int index = _deviceIndex(device);
+    AlpacaSession *session = _sessions.get(request, _clientId(request));
+    // devices without client connections keep their own state, e.g. drivers overriding aPutConnected
+    if (index < 0 || session == nullptr || !_sessions.connected(index))
+        return device->isConnected();
+    return session->connected & (1u << index);
+}
+
+// Handler for binary protocol requests, malformed packets are dropped
+void AlpacaServer::onBinary(AsyncUDPPacket &udpPacket) {
+    size_t len = _binary.handle(_device, _n_devices, udpPacket.data(), udpPacket.length());
+    if (len)
+        udpPacket.write(_binary.response(), len);
+}
+
 // Handler for replying to ascom alpaca discovery UDP packet
 void AlpacaServer::onAlpacaDiscovery(AsyncUDPPacket &udpPacket) {
     // check for arrived UDP packet at port
@@ -311,7 +709,7 @@ void AlpacaServer::onAlpacaDiscovery(AsyncUDPPacket &udpPacket) {
 
     // reply port to ascom tcp server
     uint8_t resp_buf[24];
-    int resp_len = sprintf((char *)resp_buf, "{\"AlpacaPort\":%d}", _portTCP);
+    int resp_len = sprintf((char *)resp_buf, "{\"AlpacaPort\":%d}", _config.read()->portTCP);
     _serverUDP.writeTo(resp_buf, resp_len, udpPacket.remoteIP(), udpPacket.remotePort());
     String log_message = (char *)resp_buf;
     logMessage("[ALPACA] Discovery > " + log_message);
@@ -323,41 +721,71 @@ void AlpacaServer::_getJsondata(AsyncWebServerRequest *request) {
     _writeJson(root);
     String ser_json = "";
     serializeJson(root, ser_json);
-    request->send(200, ALPACA_JSON_TYPE, ser_json);
+    sendJson(request, ser_json);
 }
 
+// setup page links, absolute when asked on the api listener and the ui runs on its own
 void AlpacaServer::_getLinks(AsyncWebServerRequest *request) {
+    String prefix = "";
+    if (_serverSetup && request->client()->localPort() != _portSetup)
+        prefix = "http://" + _ipReadable(request->client()->localIP()) + ":" + String(_portSetup);
+
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
-    root[F("Server")] = F("/setup");
+    root[F("Server")] = prefix + "/setup";
     for (int i = 0; i < _n_devices; i++) {
-        root[_device[i]->getDeviceName()] = _device[i]->getDeviceURL();
+        root[_device[i]->readConfig()->name] = prefix + _device[i]->getDeviceURL();
     }
 
     String ser_json = "";
     serializeJson(root, ser_json);
-    request->send(200, ALPACA_JSON_TYPE, ser_json);
+    sendJson(request, ser_json);
 }
 
+// boot phases in order, the api is ready at Ready and deferred phases follow
+void AlpacaServer::_getBootTimeline(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root[F("Ready")] = _bootReady;
+    root[F("Deferred")] = _deferredDone;
+    JsonArray phases = root[F("Phases")].to<JsonArray>();
+    for (int i = 0; i < _n_bootPhases; i++) {
+        JsonObject phase = phases.add<JsonObject>();
+        phase[F("Phase")] = _bootPhase[i].name;
+        if (_bootPhase[i].device >= 0)
+            phase[F("Device")] = _device[_bootPhase[i].device]->readConfig()->name;
+        phase[F("Start")] = _bootPhase[i].start;
+        phase[F("Duration")] = _bootPhase[i].duration;
+    }
+    String ser_json = "";
+    serializeJson(root, ser_json);
+    sendJson(request, ser_json);
+}
+
+// build a new config snapshot from json, readers keep the previous one until they are done
 void AlpacaServer::_readJson(JsonObject &root) {
-    const char *name = root[F("name")]; // Name
-    if (name)
-        strlcpy(_name, name, sizeof(_name));
-    _portTCP = root[F("TCP_port")] | _portTCP;
-    _portUDP = root[F("UDP_port")] | _portUDP;
+    _config.update([&root](AlpacaServerConfig &config) {
+        const char *name = root[F("name")]; // Name
+        if (name)
+            strlcpy(config.name, name, sizeof(config.name));
+        config.portTCP = root[F("TCP_port")] | config.portTCP;
+        config.portUDP = root[F("UDP_port")] | config.portUDP;
+    });
 }
 
 void AlpacaServer::_writeJson(JsonObject &root) {
     // read-only values marked with #
-    root[F("Namezro")] = _name;
+    auto config = _config.read();
+    root[F("Namezro")] = config->name;
     root[F("UIDzro")] = _uid;
-    root[F("TCP_portzro")] = _portTCP;
-    root[F("UDP_portzro")] = _portUDP;
+    root[F("TCP_portzro")] = config->portTCP;
+    root[F("UDP_portzro")] = config->portUDP;
     root[F("Versionzro")] = _version;
     root[F("Build_datezro")] = _build_date;
 }
 
 bool AlpacaServer::saveSettings() {
+    _beginDeferred();
     JsonDocument doc;
     JsonObject root = doc.to<JsonObject>();
     _writeJson(root);
@@ -382,12 +810,28 @@ bool AlpacaServer::saveSettings() {
     return true;
 }
 
-bool AlpacaServer::loadSettings() {
+// load settings now, or with the deferred initialization if that has not run yet
+bool AlpacaServer::loadSettings(bool deferred) {
+    if (deferred) {
+        _lockDeferred();
+        bool pending = !_deferredDone;
+        _settingsPending = pending;
+        _unlockDeferred();
+        if (pending)
+            return true;
+    }
+    return _loadSettings();
+}
+
+bool AlpacaServer::_loadSettings() {
+    _beginDeferred();
+    int phase = _bootBegin("settings");
     JsonDocument doc;
 
     File file = LittleFS.open(SETTINGS_FILE, FILE_READ);
     if (!file) {
         logMessage(F("[ALPACA] LittleFS could not open settings.json"));
+        _bootEnd(phase);
         return false;
     }
     DeserializationError error = deserializeJson(doc, file);
@@ -395,6 +839,7 @@ bool AlpacaServer::loadSettings() {
     file.close();
     if (error) {
         logMessage(F("[ALPACA] ArduinoJson failed to parse settings.json"));
+        _bootEnd(phase);
         return false;
     } else {
         logMessage(F("[ALPACA] ArduinoJson opened settings.json succesfully"));
@@ -405,6 +850,7 @@ bool AlpacaServer::loadSettings() {
         if (json_obj)
             _device[i]->aReadJson(json_obj);
     }
+    _bootEnd(phase);
     return true;
 }
 
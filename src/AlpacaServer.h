@@ -10,6 +10,13 @@
 #include <ESPAsyncWebServer.h>
 
 #include "AlpacaHelpers.h"
+#include "AlpacaGzip.h"
+#include "AlpacaSnapshot.h"
+#include "AlpacaScheduler.h"
+#include "AlpacaTrace.h"
+#include "AlpacaStatic.h"
+#include "AlpacaSession.h"
+#include "AlpacaBinary.h"
 // #include "config.h"
 
 // Lambda Handler Function for calling object function
@@ -31,17 +38,53 @@ class AlpacaServer {
     int logSource;
 
     AsyncWebServer *_serverTCP;
+    AsyncWebServer *_serverSetup = nullptr;
+    uint16_t _portSetup = 0;
+    AlpacaStaticLimits _setupLimits = {0, 0, 0, 0, 0};
     AsyncUDP _serverUDP;
-    uint16_t _portTCP;
-    uint16_t _portUDP;
+    AsyncUDP _serverBinary;
+    AlpacaBinary _binary;
     volatile int _serverTransactionID = 0;
     int _serverID;
     char _uid[13];
-    char _name[32];
+    AlpacaSnapshot<AlpacaServerConfig> _config;
     AlpacaDevice *_device[ALPACA_MAX_DEVICES];
     int _n_devices = 0;
+    AlpacaGzip _gzip;
+    AlpacaScheduler *_scheduler = nullptr;
+    AlpacaTrace _trace;
+    size_t _traceBytes = 0; // body size of the request being handled, set by sendJson
+    AlpacaSessions _sessions;
+    // reading filled by respond() to the null request of a binary protocol read, see alpacaReadRaw()
+    AlpacaReading *_captureReading = nullptr;
+    int32_t _captureError = 0;
+    bool _captured = false;
+    char _captureString[ALPACA_BINARY_MAX_STRING];
+
+    // boot timeline, routes come up first, LittleFS and settings are deferred to update()
+    AlpacaBootPhase _bootPhase[ALPACA_BOOT_PHASES];
+    int _n_bootPhases = 0;
+    uint32_t _bootReady = 0;
+    volatile bool _deferredDone = false;
+    bool _settingsPending = false;
+    SemaphoreHandle_t _deferredLock = nullptr;
+    // registered on the setup listener, moved there by a later beginSetup()
+    AsyncWebHandler *_setupHandler[ALPACA_SETUP_HANDLERS];
+    int _n_setupHandlers = 0;
+
+    int _bootBegin(const char *name, int8_t device = -1);
+    void _bootEnd(int phase);
+    void _startDeferred();
+    static void _deferredTask(void *arg);
+    void _beginDeferred();
+    void _lockDeferred();
+    void _unlockDeferred();
+    void _addSetupHandler(AsyncWebHandler *handler);
+    bool _loadSettings();
+    void _getBootTimeline(AsyncWebServerRequest *request);
 
     void _registerCallbacks();
+    void _registerSetupCallbacks();
     void _getApiVersions(AsyncWebServerRequest *request);
     void _getDescription(AsyncWebServerRequest *request);
     void _getConfiguredDevices(AsyncWebServerRequest *request);
@@ -50,6 +93,16 @@ class AlpacaServer {
     void _writeJson(JsonObject &root);
     void _getJsondata(AsyncWebServerRequest *request);
     void _getLinks(AsyncWebServerRequest *request);
+    void _getCompression(AsyncWebServerRequest *request);
+    void _getScheduler(AsyncWebServerRequest *request);
+    void _getTrace(AsyncWebServerRequest *request);
+    void _getSessions(AsyncWebServerRequest *request);
+    void _getBinary(AsyncWebServerRequest *request);
+    uint32_t _clientId(AsyncWebServerRequest *request);
+    int _deviceIndex(AlpacaDevice *device);
+    bool _capture(AsyncWebServerRequest *request, const AlpacaReading &reading, int32_t error_number);
+    void _syncConnected(uint32_t devices);
+    bool _acceptsGzip(AsyncWebServerRequest *request);
 
     String _ipReadable(IPAddress address);
     String _minifyJson(String s);
@@ -69,7 +122,18 @@ class AlpacaServer {
     void begin(uint16_t udp_port, uint16_t tcp_port);
     void beginTcp(AsyncWebServer *tcp_server, uint16_t tcp_port);
     void beginUdp(uint16_t udp_port);
+    void beginBinary(uint16_t port = ALPACA_BINARY_PORT);
+    void beginSetup(uint16_t port, uint8_t max_connections = ALPACA_SETUP_MAX_CONNECTIONS, uint32_t bandwidth = 0);
     void addDevice(AlpacaDevice *device);
+    void update();
+    void setScheduler(AlpacaScheduler *scheduler) { _scheduler = scheduler; }
+    AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction fn);
+    bool enableTrace() { return _trace.begin(); }
+    bool saveTrace(const char *path = ALPACA_TRACE_FILE);
+    uint32_t requestBegin(AsyncWebServerRequest *request);
+    void requestEnd(AsyncWebServerRequest *request, uint32_t start);
+    bool connectDevice(AsyncWebServerRequest *request, AlpacaDevice *device, bool connected);
+    bool isConnected(AsyncWebServerRequest *request, AlpacaDevice *device);
     bool getParam(AsyncWebServerRequest *request, const char *name, bool &value);
     bool getParam(AsyncWebServerRequest *request, const char *name, float &value);
     bool getParam(AsyncWebServerRequest *request, const char *name, int &value);
@@ -78,9 +142,19 @@ class AlpacaServer {
     void respond(AsyncWebServerRequest *request, int32_t value, int32_t error_number = 0, const char *error_message = "");
     void respond(AsyncWebServerRequest *request, float value, int32_t error_number = 0, const char *error_message = "");
     void respond(AsyncWebServerRequest *request, const char *value, int32_t error_number = 0, const char *error_message = "");
-    bool loadSettings();
+    void sendJson(AsyncWebServerRequest *request, const char *json, size_t len);
+    void captureBegin(AlpacaReading &reading);
+    int32_t captureEnd();
+    void sendJson(AsyncWebServerRequest *request, const String &json) { sendJson(request, json.c_str(), json.length()); }
+    bool loadSettings(bool deferred = false);
     bool saveSettings();
     void onAlpacaDiscovery(AsyncUDPPacket &udpPacket);
+    void onBinary(AsyncUDPPacket &udpPacket);
+    bool logEnabled() { return logLine && logLinePart; }
     AsyncWebServer *getServerTCP() { return _serverTCP; }
+    AsyncWebServer *getServerSetup() { return _serverSetup ? _serverSetup : _serverTCP; }
+    AlpacaStaticHandler &serveSetup(const char *uri, const char *path);
+    AsyncCallbackWebHandler &onSetup(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction fn);
+    AsyncWebHandler &addSetupHandler(AsyncWebHandler *handler);
     const char *getUID() { return _uid; }
 };
@@ -0,0 +1,138 @@
+#include "AlpacaSession.h"
+
+static_assert(ALPACA_MAX_DEVICES <= 32, "connected state is a 32 bit mask");
+
+AlpacaSessions::AlpacaSessions() {
+    memset(_session, 0, sizeof(_session));
+    memset(_refs, 0, sizeof(_refs));
+}
+
+AlpacaSession *AlpacaSessions::_find(uint32_t client_id, uint32_t ip) {
+    for (int i = 0; i < ALPACA_MAX_SESSIONS; i++) {
+        if (_session[i].ip == ip && _session[i].clientId == client_id)
+            return &_session[i];
+    }
+    return nullptr;
+}
+
+void AlpacaSessions::_release(AlpacaSession &session) {
+    for (int device = 0; device < ALPACA_MAX_DEVICES; device++) {
+        if (session.connected & (1u << device)) {
+            _refs[device]--;
+            _changed |= 1u << device;
+        }
+    }
+    memset(&session, 0, sizeof(session));
+}
+
+// clients that stopped polling give up their connections
+void AlpacaSessions::_expire(uint32_t now) {
+    for (int i = 0; i < ALPACA_MAX_SESSIONS; i++) {
+        if (_session[i].ip != 0 && now - _session[i].seen > ALPACA_SESSION_TIMEOUT * 1000UL) {
+            _release(_session[i]);
+            _expired++;
+        }
+    }
+}
+
+// find or add the session, a full table evicts the idlest client that has nothing connected
+AlpacaSession *AlpacaSessions::get(AsyncWebServerRequest *request, uint32_t client_id) {
+    uint32_t ip = request->client()->remoteIP();
+    AlpacaSession *session = _find(client_id, ip);
+    if (session)
+        return session;
+
+    uint32_t now = millis();
+    for (int i = 0; i < ALPACA_MAX_SESSIONS; i++) {
+        AlpacaSession &candidate = _session[i];
+        if (candidate.ip == 0) {
+            session = &candidate;
+            break;
+        }
+        if (candidate.connected == 0 && (session == nullptr || now - candidate.seen > now - session->seen))
+            session = &candidate;
+    }
+    if (session == nullptr)
+        return nullptr;
+    memset(session, 0, sizeof(AlpacaSession));
+    session->clientId = client_id;
+    session->ip = ip;
+    session->seen = now;
+    return session;
+}
+
+// account the request and tune new sockets
+void AlpacaSessions::open(AsyncWebServerRequest *request, uint32_t client_id) {
+    uint32_t now = millis();
+    _expire(now);
+    _requests++;
+
+    AsyncClient *client = request->client();
+    AlpacaSession *session = get(request, client_id);
+    bool reused = session && session->requests > 0 && session->port == client->remotePort();
+    if (!reused) {
+        _active++;
+        _sockets++;
+        request->onDisconnect([this]() { _active--; });
+        client->setNoDelay(true);
+        client->setRxTimeout(ALPACA_IDLE_TIMEOUT);
+    }
+    if (session == nullptr) {
+        _untracked++;
+        return;
+    }
+    session->port = client->remotePort();
+    session->seen = now;
+    session->requests++;
+    if (!reused)
+        session->sockets++;
+}
+
+// set the client's state, returns true while any client has the device connected
+bool AlpacaSessions::connect(AlpacaSession *session, int device, bool connected) {
+    uint32_t bit = 1u << device;
+    if (connected && !(session->connected & bit)) {
+        session->connected |= bit;
+        _refs[device]++;
+    } else if (!connected && (session->connected & bit)) {
+        session->connected &= ~bit;
+        _refs[device]--;
+    }
+    return _refs[device] > 0;
+}
+
+// devices released by expired sessions since the last call
+uint32_t AlpacaSessions::changed() {
+    uint32_t changed = _changed;
+    _changed = 0;
+    return changed;
+}
+
+void AlpacaSessions::writeStats(JsonObject root) {
+    uint32_t reused = _requests - _sockets;
+    root[F("Requests")] = _requests;
+    root[F("Sockets")] = _sockets;
+    root[F("Reused")] = reused;
+    root[F("ReuseRate")] = _requests ? (float)reused / _requests : 0.0f;
+    root[F("Active")] = _active;
+    root[F("Untracked")] = _untracked;
+    root[F("Expired")] = _expired;
+    JsonArray refs = root[F("Clients")].to<JsonArray>();
+    for (int device = 0; device < ALPACA_MAX_DEVICES; device++)
+        refs.add(_refs[device]);
+
+    uint32_t now = millis();
+    JsonArray sessions = root[F("Sessions")].to<JsonArray>();
+    for (int i = 0; i < ALPACA_MAX_SESSIONS; i++) {
+        AlpacaSession &session = _session[i];
+        if (session.ip == 0)
+            continue;
+        JsonObject obj = sessions.add<JsonObject>();
+        obj[F("ClientID")] = session.clientId;
+        obj[F("IP")] = IPAddress(session.ip).toString();
+        obj[F("Requests")] = session.requests;
+        obj[F("Sockets")] = session.sockets;
+        obj[F("Connected")] = session.connected;
+        obj[F("IdleMs")] = now - session.seen;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include "AlpacaHelpers.h"
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_MAX_SESSIONS
+#define ALPACA_MAX_SESSIONS 16
+#endif
+#ifndef ALPACA_IDLE_TIMEOUT
+#define ALPACA_IDLE_TIMEOUT 5 // seconds, api sockets without data are closed
+#endif
+#ifndef ALPACA_SESSION_TIMEOUT
+#define ALPACA_SESSION_TIMEOUT 600 // seconds without requests before a client's connections are released
+#endif
+
+typedef struct {
+    uint32_t clientId;  // ClientID parameter, 0 if the client sends none
+    uint32_t ip;        // 0 = free slot
+    uint16_t port;      // remote port of the last request
+    uint32_t connected; // bit per device slot
+    uint32_t seen;      // millis of the last request
+    uint32_t requests;
+    uint32_t sockets; // requests that arrived on a new connection
+} AlpacaSession;
+
+// Client sessions keyed by ClientID and remote address, only touched from the web server task.
+// Holds the connected state per client, counts clients per device
+// and tunes the api sockets.
+class AlpacaSessions {
+  private:
+    AlpacaSession _session[ALPACA_MAX_SESSIONS];
+    uint8_t _refs[ALPACA_MAX_DEVICES];
+    uint8_t _active = 0;
+    uint32_t _changed = 0; // bit per device slot released by an expired session
+    // statistics
+    uint32_t _requests = 0;
+    uint32_t _sockets = 0;
+    uint32_t _untracked = 0;
+    uint32_t _expired = 0;
+
+    AlpacaSession *_find(uint32_t client_id, uint32_t ip);
+    void _release(AlpacaSession &session);
+    void _expire(uint32_t now);
+
+  public:
+    AlpacaSessions();
+    void open(AsyncWebServerRequest *request, uint32_t client_id);
+    AlpacaSession *get(AsyncWebServerRequest *request, uint32_t client_id);
+    bool connect(AlpacaSession *session, int device, bool connected);
+    bool connected(int device) { return _refs[device] > 0; }
+    uint32_t changed();
+    void writeStats(JsonObject root);
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <functional>
+#include "AlpacaBus.h"
+
+// simulated bus for host testing, devices are callbacks and time is counted instead of spent,
+// header only and without Arduino or FreeRTOS dependencies
+class AlpacaSimBus : public AlpacaBus {
+  public:
+    typedef std::function<bool(const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len)> Device;
+
+  private:
+    Device _device[128];
+    uint32_t _byteUs = 90; // 100 kHz
+    uint32_t _elapsed = 0;
+    uint32_t _transfers = 0;
+
+  public:
+    void setDevice(uint8_t address, Device device) { _device[address & 0x7F] = device; }
+    void setByteTime(uint32_t us) { _byteUs = us; }
+    uint32_t elapsed() { return _elapsed; }
+    uint32_t transfers() { return _transfers; }
+    bool transfer(uint8_t address, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+        _transfers++;
+        _elapsed += (1 + tx_len + rx_len) * _byteUs;
+        Device &device = _device[address & 0x7F];
+        if (!device)
+            return false; // nack
+        return device(tx, tx_len, rx, rx_len);
+    }
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Double buffered configuration snapshot.
+// Readers pin the published copy without locking, writers fill the spare copy and publish it
+// with an atomic pointer swap. A copy is only reused once the readers pinned to it are gone.
+template <typename T>
+class AlpacaSnapshot {
+  private:
+    T _slot[2];
+    std::atomic<T *> _current;
+    std::atomic<int> _readers[2];
+    SemaphoreHandle_t _writer;
+
+    T *_pin() {
+        while (true) {
+            T *value = _current.load();
+            _readers[value - _slot]++;
+            // recheck, a writer may have recycled the copy before we pinned it
+            if (_current.load() == value)
+                return value;
+            _readers[value - _slot]--;
+        }
+    }
+
+    void _unpin(T *value) {
+        _readers[value - _slot]--;
+    }
+
+  public:
+    // read guard, keep it short lived and never across update() in the same task
+    class Reader {
+      private:
+        AlpacaSnapshot *_owner;
+        T *_value;
+
+      public:
+        Reader(AlpacaSnapshot *owner) : _owner(owner), _value(owner->_pin()) {}
+        Reader(Reader &&other) : _owner(other._owner), _value(other._value) { other._value = nullptr; }
+        Reader(const Reader &) = delete;
+        ~Reader() {
+            if (_value)
+                _owner->_unpin(_value);
+        }
+        const T *operator->() const { return _value; }
+        const T &operator*() const { return *_value; }
+    };
+
+    AlpacaSnapshot() : _slot(), _current(&_slot[0]) {
+        _readers[0] = 0;
+        _readers[1] = 0;
+        _writer = xSemaphoreCreateMutex();
+    }
+
+    // fill the first copy in place, for owners constructed during static init where update() must not block
+    template <typename F>
+    explicit AlpacaSnapshot(F init) : AlpacaSnapshot() {
+        init(_slot[0]);
+    }
+
+    Reader read() { return Reader(this); }
+
+    // copy current values to the spare copy, let fn modify it and publish
+    template <typename F>
+    void update(F fn) {
+        xSemaphoreTake(_writer, portMAX_DELAY);
+        T *current = _current.load();
+        T *spare = (current == &_slot[0]) ? &_slot[1] : &_slot[0];
+        while (_readers[spare - _slot].load() != 0)
+            vTaskDelay(1);
+        *spare = *current;
+        fn(*spare);
+        _current.store(spare);
+        xSemaphoreGive(_writer);
+    }
+};
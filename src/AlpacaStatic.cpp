@@ -0,0 +1,104 @@
+#include "AlpacaStatic.h"
+
+// path ending in '/' maps a directory, otherwise uri must match exactly
+AlpacaStaticHandler::AlpacaStaticHandler(const char *uri, const char *path, AlpacaStaticLimits *limits)
+    : _uri(uri), _path(path), _limits(limits) {
+}
+
+AlpacaStaticHandler &AlpacaStaticHandler::setCacheControl(const char *cache_control) {
+    _cacheControl = cache_control;
+    return *this;
+}
+
+bool AlpacaStaticHandler::canHandle(AsyncWebServerRequest *request) const {
+    if (request->method() != HTTP_GET)
+        return false;
+    const String &url = request->url();
+    if (_path.endsWith("/"))
+        return url.startsWith(_uri + "/");
+    return url == _uri;
+}
+
+const char *AlpacaStaticHandler::_contentType(const String &path) {
+    if (path.endsWith(".html"))
+        return "text/html";
+    if (path.endsWith(".css"))
+        return "text/css";
+    if (path.endsWith(".js"))
+        return "application/javascript";
+    if (path.endsWith(".json"))
+        return "application/json";
+    if (path.endsWith(".ico"))
+        return "image/x-icon";
+    if (path.endsWith(".webp"))
+        return "image/webp";
+    return "text/plain";
+}
+
+// token bucket, only touched from the web server task
+size_t AlpacaStaticHandler::_take(AlpacaStaticLimits *limits, size_t wanted) {
+    wanted = min(wanted, (size_t)ALPACA_SETUP_CHUNK);
+    if (limits->bandwidth == 0)
+        return wanted;
+    uint32_t now = millis();
+    uint32_t refill = (uint64_t)(now - limits->refilled) * limits->bandwidth / 1000;
+    if (refill > 0) {
+        limits->tokens = min(limits->tokens + refill, (uint32_t)ALPACA_SETUP_CHUNK * 2);
+        limits->refilled = now;
+    }
+    size_t granted = min(wanted, (size_t)limits->tokens);
+    limits->tokens -= granted;
+    return granted;
+}
+
+// a transfer waits for a free slot instead of failing, browsers don't retry scripts and styles
+bool AlpacaStaticHandler::_acquire(AlpacaStaticLimits *limits) {
+    if (limits->maxConnections == 0)
+        return true;
+    if (limits->active >= limits->maxConnections)
+        return false;
+    limits->active++;
+    return true;
+}
+
+void AlpacaStaticHandler::handleRequest(AsyncWebServerRequest *request) {
+    String path = _path;
+    if (_path.endsWith("/"))
+        path += request->url().substring(_uri.length() + 1);
+
+    bool gzipped = false;
+    File file;
+    if (LittleFS.exists(path + ".gz")) {
+        file = LittleFS.open(path + ".gz", FILE_READ);
+        gzipped = true;
+    } else if (LittleFS.exists(path)) {
+        file = LittleFS.open(path, FILE_READ);
+    }
+    if (!file || file.isDirectory()) {
+        request->send(404);
+        return;
+    }
+
+    AlpacaStaticLimits *limits = _limits;
+    std::shared_ptr<bool> slot = std::make_shared<bool>(false);
+    request->onDisconnect([limits, slot]() {
+        if (*slot && limits->maxConnections)
+            limits->active--;
+    });
+    AsyncWebServerResponse *response = request->beginResponse(_contentType(path), file.size(), [file, limits, slot](uint8_t *buffer, size_t max_len, size_t index) mutable -> size_t {
+        if (!*slot) {
+            if (!_acquire(limits))
+                return RESPONSE_TRY_AGAIN;
+            *slot = true;
+        }
+        size_t len = _take(limits, max_len);
+        if (len == 0)
+            return RESPONSE_TRY_AGAIN;
+        return file.read(buffer, len);
+    });
+    if (gzipped)
+        response->addHeader("Content-Encoding", "gzip");
+    if (_cacheControl.length())
+        response->addHeader("Cache-Control", _cacheControl);
+    request->send(response);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include <memory>
+#include <LittleFS.h>
+#include <ESPAsyncWebServer.h>
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_SETUP_MAX_CONNECTIONS
+#define ALPACA_SETUP_MAX_CONNECTIONS 4
+#endif
+#ifndef ALPACA_SETUP_CHUNK
+#define ALPACA_SETUP_CHUNK 1024 // max bytes per send, keeps api responses interleaved
+#endif
+
+// limits shared by all static handlers of the setup listener, set by beginSetup()
+typedef struct {
+    uint8_t maxConnections; // 0 = unlimited
+    uint8_t active;
+    uint32_t bandwidth; // bytes per second, 0 = unlimited
+    uint32_t tokens;
+    uint32_t refilled;
+} AlpacaStaticLimits;
+
+// Static file handler for the setup ui.
+// Serves pre-gzipped files like serveStatic, but in small chunks, under a shared bandwidth cap
+// and with a limit on concurrent transfers so ui loads can't starve the alpaca api.
+// Transfers over the limit are queued until a slot frees up.
+class AlpacaStaticHandler : public AsyncWebHandler {
+  private:
+    String _uri;
+    String _path;
+    String _cacheControl;
+    AlpacaStaticLimits *_limits;
+
+    static const char *_contentType(const String &path);
+    static bool _acquire(AlpacaStaticLimits *limits);
+    static size_t _take(AlpacaStaticLimits *limits, size_t wanted);
+
+  public:
+    AlpacaStaticHandler(const char *uri, const char *path, AlpacaStaticLimits *limits);
+    AlpacaStaticHandler &setCacheControl(const char *cache_control);
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+};
@@ -0,0 +1,94 @@
+#include "AlpacaTrace.h"
+
+AlpacaTrace::AlpacaTrace() : _head(0), _n_routes(0) {
+}
+
+// allocate ring and route dictionary, psram when the board has it
+bool AlpacaTrace::begin() {
+    if (_record)
+        return true;
+    uint32_t caps = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_DEFAULT;
+    _route = (AlpacaTraceRoute *)heap_caps_calloc(ALPACA_TRACE_ROUTES, sizeof(AlpacaTraceRoute), caps);
+    AlpacaTraceRecord *record = (AlpacaTraceRecord *)heap_caps_calloc(ALPACA_TRACE_RECORDS, sizeof(AlpacaTraceRecord), caps);
+    if (_route == nullptr || record == nullptr) {
+        free(_route);
+        free(record);
+        _route = nullptr;
+        return false;
+    }
+    _record = record;
+    return true;
+}
+
+// FNV-1a of method and url, new routes are added to the dictionary
+uint32_t AlpacaTrace::route(char method, const String &url) {
+    uint32_t id = 2166136261u;
+    id = (id ^ (uint8_t)method) * 16777619u;
+    for (unsigned i = 0; i < url.length(); i++)
+        id = (id ^ (uint8_t)url[i]) * 16777619u;
+
+    uint32_t n = _n_routes.load();
+    for (uint32_t i = 0; i < n; i++) {
+        if (_route[i].id == id)
+            return id;
+    }
+    if (n < ALPACA_TRACE_ROUTES) {
+        _route[n].id = id;
+        _route[n].method = method;
+        strlcpy(_route[n].url, url.c_str(), sizeof(_route[n].url));
+        _n_routes.store(n + 1);
+    }
+    return id;
+}
+
+void AlpacaTrace::record(uint32_t route, uint32_t start, uint32_t duration, uint32_t client, size_t size, const char *params, size_t params_len, bool truncated) {
+    if (_record == nullptr)
+        return;
+    uint32_t head = _head.load();
+    AlpacaTraceRecord &record = _record[head % ALPACA_TRACE_RECORDS];
+    record.start = start;
+    record.duration = duration;
+    record.route = route;
+    record.client = client;
+    record.size = min(size, (size_t)UINT16_MAX);
+    size_t len = min(params_len, (size_t)ALPACA_TRACE_PARAMS);
+    memcpy(record.params, params, len);
+    record.paramsLen = len | ((truncated || len < params_len) ? ALPACA_TRACE_TRUNCATED : 0);
+    _head.store(head + 1);
+}
+
+// export as header, route dictionary and records, all little endian
+size_t AlpacaTrace::write(Print &out) {
+    if (_record == nullptr)
+        return 0;
+    uint32_t head = _head.load();
+    uint32_t first = (head > ALPACA_TRACE_RECORDS) ? head - ALPACA_TRACE_RECORDS : 0;
+    uint16_t n_routes = _n_routes.load();
+
+    // copy records first, then drop the ones the writer lapped meanwhile
+    AlpacaTraceRecord *copy = (AlpacaTraceRecord *)malloc((head - first) * sizeof(AlpacaTraceRecord) + 1);
+    if (copy == nullptr)
+        return 0;
+    for (uint32_t i = first; i < head; i++)
+        copy[i - first] = _record[i % ALPACA_TRACE_RECORDS];
+    uint32_t now = _head.load();
+    uint32_t valid = (now >= ALPACA_TRACE_RECORDS) ? now - ALPACA_TRACE_RECORDS + 1 : 0;
+    uint32_t skip = (valid > first) ? min(valid - first, head - first) : 0;
+    uint32_t count = head - first - skip;
+
+    uint16_t version = ALPACA_TRACE_VERSION;
+    size_t written = out.write((const uint8_t *)ALPACA_TRACE_MAGIC, 4);
+    written += out.write((const uint8_t *)&version, sizeof(version));
+    written += out.write((const uint8_t *)&n_routes, sizeof(n_routes));
+    written += out.write((const uint8_t *)&count, sizeof(count));
+    for (uint16_t i = 0; i < n_routes; i++) {
+        uint8_t len = strlen(_route[i].url);
+        written += out.write((const uint8_t *)&_route[i].id, sizeof(_route[i].id));
+        written += out.write((const uint8_t *)&_route[i].method, 1);
+        written += out.write(&len, 1);
+        written += out.write((const uint8_t *)_route[i].url, len);
+    }
+    written += out.write((const uint8_t *)(copy + skip), count * sizeof(AlpacaTraceRecord));
+    free(copy);
+    return written;
+}
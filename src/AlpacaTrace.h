@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// settings, may be overridden with build flags
+#ifndef ALPACA_TRACE_RECORDS
+#define ALPACA_TRACE_RECORDS 256
+#endif
+#ifndef ALPACA_TRACE_ROUTES
+#define ALPACA_TRACE_ROUTES 128
+#endif
+#define ALPACA_TRACE_PARAMS 45
+#define ALPACA_TRACE_URL 63
+#define ALPACA_TRACE_MAGIC "ATRC"
+#define ALPACA_TRACE_VERSION 2
+#define ALPACA_TRACE_TRUNCATED 0x80 // paramsLen flag, the parameters did not fit
+
+// one request, times in microseconds since boot
+typedef struct __attribute__((packed)) {
+    uint32_t start;
+    uint32_t duration;
+    uint32_t route;
+    uint32_t client;
+    uint16_t size;
+    uint8_t paramsLen;                // length, ALPACA_TRACE_TRUNCATED if params is cut short
+    char params[ALPACA_TRACE_PARAMS]; // "name=value&..."
+} AlpacaTraceRecord;
+static_assert(sizeof(AlpacaTraceRecord) == 64, "Wrong size of struct");
+
+// route dictionary entry, id is a hash of method and url
+typedef struct {
+    uint32_t id;
+    char method;
+    char url[ALPACA_TRACE_URL];
+} AlpacaTraceRoute;
+
+// Request recorder.
+// Single writer (the web server task) appends to a ring and publishes with an atomic head,
+// exporters copy without locking and drop records that were overwritten while copying.
+class AlpacaTrace {
+  private:
+    AlpacaTraceRecord *_record = nullptr;
+    AlpacaTraceRoute *_route = nullptr;
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _n_routes;
+
+  public:
+    AlpacaTrace();
+    bool begin();
+    bool enabled() { return _record != nullptr; }
+    uint32_t route(char method, const String &url);
+    void record(uint32_t route, uint32_t start, uint32_t duration, uint32_t client, size_t size, const char *params, size_t params_len, bool truncated);
+    size_t write(Print &out);
+};
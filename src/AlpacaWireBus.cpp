@@ -0,0 +1,18 @@
+#include "AlpacaWireBus.h"
+
+bool AlpacaWireBus::transfer(uint8_t address, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+    if (tx_len > 0) {
+        _wire.beginTransmission(address);
+        _wire.write(tx, tx_len);
+        // repeated start when a read follows
+        if (_wire.endTransmission(rx_len == 0) != 0)
+            return false;
+    }
+    if (rx_len == 0)
+        return true;
+    if (_wire.requestFrom((uint16_t)address, rx_len) != rx_len)
+        return false;
+    for (size_t i = 0; i < rx_len; i++)
+        rx[i] = _wire.read();
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <Wire.h>
+#include "AlpacaScheduler.h"
+
+// I2C backend for AlpacaScheduler
+class AlpacaWireBus : public AlpacaBus {
+  private:
+    TwoWire &_wire;
+
+  public:
+    AlpacaWireBus(TwoWire &wire = Wire) : _wire(wire) {}
+    bool transfer(uint8_t address, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len);
+};
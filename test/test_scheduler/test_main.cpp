@@ -0,0 +1,149 @@
+#include <unity.h>
+#include "AlpacaScheduler.h"
+#include "AlpacaSimBus.h"
+#include <chrono>
+
+// drives AlpacaScheduler::poll() with a simulated clock over AlpacaSimBus
+
+static AlpacaSimBus *bus;
+static AlpacaScheduler *scheduler;
+static int calls;
+static int failed;
+
+static void count(bool ok, const uint8_t *data, size_t len) {
+    calls++;
+    if (!ok)
+        failed++;
+}
+
+static bool ack(const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+    for (size_t i = 0; i < rx_len; i++)
+        rx[i] = i;
+    return true;
+}
+
+void setUp(void) {
+    bus = new AlpacaSimBus();
+    bus->setDevice(0x44, ack);
+    scheduler = new AlpacaScheduler(bus);
+    calls = 0;
+    failed = 0;
+}
+
+void tearDown(void) {
+    delete scheduler;
+    delete bus;
+}
+
+void test_period_validation(void) {
+    const uint8_t command[] = {0x24, 0x00};
+    TEST_ASSERT_EQUAL(-1, scheduler->addJob("zero", 0x44, command, 2, 6, 0, count));
+    TEST_ASSERT_EQUAL(-1, scheduler->addJob("long", 0x44, command, 2, 6, ALPACA_BUS_MAX_PERIOD_MS + 1, count));
+    TEST_ASSERT_EQUAL(-1, scheduler->addJob("conversion", 0x44, command, 2, 6, 10, count, 10000));
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("max", 0x44, command, 2, 6, ALPACA_BUS_MAX_PERIOD_MS, count));
+    TEST_ASSERT_EQUAL(ALPACA_BUS_MAX_PERIOD_MS * 1000u, scheduler->job(0)->periodUs);
+}
+
+void test_short_period_runs_once_per_poll(void) {
+    // 1 ms is shorter than the burst window
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("fast", 0x44, nullptr, 0, 2, 1, count));
+    uint32_t now = 5000;
+    for (int i = 0; i < 10; i++) {
+        uint32_t wait = scheduler->poll(now);
+        TEST_ASSERT_EQUAL(i + 1, calls);
+        TEST_ASSERT_EQUAL_UINT32(1000, wait);
+        now += wait;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->job(0)->overruns);
+}
+
+void test_conversion_read(void) {
+    const uint8_t command[] = {0x24, 0x00};
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("sht31", 0x44, command, 2, 6, 1000, count, 15000));
+    // the read is due 15 ms after the command, plus the little real time the poll took
+    uint32_t wait = scheduler->poll(0);
+    TEST_ASSERT_EQUAL(0, calls);
+    TEST_ASSERT_TRUE(wait >= 15000 && wait < 16000);
+    scheduler->poll(14999);
+    TEST_ASSERT_EQUAL(0, calls);
+    scheduler->poll(wait);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL(0, failed);
+    TEST_ASSERT_EQUAL_UINT32(2, bus->transfers());
+}
+
+// a transfer that takes 3 ms of real time, the scheduler times the burst with the bus clock
+static bool slow(const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(3000);
+    while (std::chrono::steady_clock::now() < until) {
+    }
+    return ack(tx, tx_len, rx, rx_len);
+}
+
+void test_conversion_after_burst(void) {
+    const uint8_t command[] = {0x24, 0x00};
+    bus->setDevice(0x40, slow);
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("slow", 0x40, nullptr, 0, 2, 1000, count));
+    TEST_ASSERT_EQUAL(1, scheduler->addJob("sht31", 0x44, command, 2, 6, 1000, count, 5000));
+    // the command goes out after the slow transfer, its read must wait for the full conversion from then
+    uint32_t wait = scheduler->poll(0);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_TRUE(wait >= 8000);
+    scheduler->poll(5000);
+    TEST_ASSERT_EQUAL(1, calls);
+    scheduler->poll(wait);
+    TEST_ASSERT_EQUAL(2, calls);
+}
+
+void test_overruns_after_long_gap(void) {
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("slow", 0x44, nullptr, 0, 2, 1000, count));
+    scheduler->poll(0);
+    // the scheduler task stalled for 20 min
+    uint32_t wait = scheduler->poll(20u * 60 * 1000000);
+    TEST_ASSERT_EQUAL(2, calls);
+    TEST_ASSERT_EQUAL_UINT32(20 * 60 - 1, scheduler->job(0)->overruns);
+    TEST_ASSERT_EQUAL_UINT32(1000000, wait);
+}
+
+void test_max_period(void) {
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("daily", 0x44, nullptr, 0, 2, ALPACA_BUS_MAX_PERIOD_MS, count));
+    uint32_t period = ALPACA_BUS_MAX_PERIOD_MS * 1000u;
+    scheduler->poll(0);
+    TEST_ASSERT_EQUAL(1, calls);
+    TEST_ASSERT_EQUAL_UINT32(ALPACA_BUS_IDLE_US, scheduler->poll(period - 2 * ALPACA_BUS_IDLE_US));
+    TEST_ASSERT_EQUAL_UINT32(ALPACA_BUS_COALESCE_US + 1, scheduler->poll(period - ALPACA_BUS_COALESCE_US - 1));
+    TEST_ASSERT_EQUAL(1, calls);
+    scheduler->poll(period);
+    TEST_ASSERT_EQUAL(2, calls);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler->job(0)->overruns);
+}
+
+void test_overruns_across_wrap(void) {
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("slow", 0x44, nullptr, 0, 2, 1000, count));
+    uint32_t now = 0xFFFFFFFFu - 500000;
+    scheduler->poll(now);
+    scheduler->poll(now + 3500000);
+    TEST_ASSERT_EQUAL(2, calls);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler->job(0)->overruns);
+}
+
+void test_nack_counts_errors(void) {
+    TEST_ASSERT_EQUAL(0, scheduler->addJob("absent", 0x45, nullptr, 0, 2, 100, count));
+    scheduler->poll(0);
+    scheduler->poll(100000);
+    TEST_ASSERT_EQUAL(2, failed);
+    TEST_ASSERT_EQUAL_UINT32(2, scheduler->job(0)->errors);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_period_validation);
+    RUN_TEST(test_short_period_runs_once_per_poll);
+    RUN_TEST(test_conversion_read);
+    RUN_TEST(test_conversion_after_burst);
+    RUN_TEST(test_overruns_after_long_gap);
+    RUN_TEST(test_max_period);
+    RUN_TEST(test_overruns_across_wrap);
+    RUN_TEST(test_nack_counts_errors);
+    return UNITY_END();
+}
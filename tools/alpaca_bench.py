@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""Compare polling a running AlpacaServer over HTTP/JSON with the binary UDP protocol (see beginBinary()).
+
+    alpaca_bench.py <ip> temperature position               # device 0, 200 poll cycles
+    alpaca_bench.py <ip> issafe --device 1 -n 1000 --rate 10
+    alpaca_bench.py <ip> temperature --connect              # PUT connected=true first
+
+Each poll cycle reads all listed properties of one device: one HTTP request per property,
+one datagram per property, and one batched datagram for all of them.
+"""
+import argparse
+import json
+import random
+import socket
+import struct
+import sys
+import time
+import urllib.parse
+import urllib.request
+
+TYPES = {1: ("B", 1), 2: ("<i", 4), 3: ("<f", 4)}
+
+
+def configured_devices(host, port):
+    with urllib.request.urlopen("http://%s:%d/management/v1/configureddevices" % (host, port)) as response:
+        return json.load(response)["Value"]
+
+
+def http_get(host, port, path):
+    """one request on a new connection, as the server closes it after the response, returns bytes sent and received"""
+    request = ("GET %s HTTP/1.1\r\nHost: %s\r\n\r\n" % (path, host)).encode()
+    with socket.create_connection((host, port), timeout=2) as sock:
+        sock.sendall(request)
+        received = b""
+        while True:
+            data = sock.recv(2048)
+            if not data:
+                break
+            received += data
+    body = received.split(b"\r\n\r\n", 1)[1]
+    value = json.loads(body)
+    if value.get("ErrorNumber"):
+        raise RuntimeError("%s: %s" % (path, value.get("ErrorMessage")))
+    return len(request), len(received)
+
+
+def binary_request(sock, address, device, names):
+    transaction = random.getrandbits(32)
+    packet = b"AB" + bytes([1, len(names)]) + struct.pack("<I", transaction)
+    for name in names:
+        packet += bytes([device, len(name)]) + name.encode()
+    sock.sendto(packet, address)
+    while True:
+        response, _ = sock.recvfrom(1472)
+        if response[4:8] == packet[4:8]:
+            break
+    offset = 8
+    values = []
+    for name in names:
+        error, kind = struct.unpack_from("<iB", response, offset)
+        offset += 5
+        # alpaca error number, 0x400 not implemented, 0x407 not connected, 0x500 - 0xFFF driver errors
+        if error:
+            raise RuntimeError("%s: error 0x%x" % (name, error))
+        if kind == 4:
+            length = response[offset]
+            values.append(response[offset + 1:offset + 1 + length].decode())
+            offset += 1 + length
+        else:
+            fmt, size = TYPES[kind]
+            values.append(struct.unpack_from(fmt, response, offset)[0])
+            offset += size
+    return len(packet), len(response), values
+
+
+def run(name, cycles, rate, poll):
+    latency = []
+    sent = received = lost = 0
+    for _ in range(cycles):
+        t0 = time.perf_counter()
+        try:
+            out, back = poll()
+            sent += out
+            received += back
+            latency.append((time.perf_counter() - t0) * 1000)
+        except socket.timeout:
+            lost += 1
+        if rate:
+            time.sleep(max(0, 1 / rate - (time.perf_counter() - t0)))
+    latency.sort()
+    if not latency:
+        print("%-16s all %d cycles lost" % (name, cycles))
+        return
+    mean = sum(latency) / len(latency)
+    p95 = latency[min(len(latency) - 1, int(len(latency) * 0.95))]
+    ok = len(latency)
+    print("%-16s mean %7.2f ms  p50 %7.2f ms  p95 %7.2f ms  %6d B out  %6d B in per cycle  %d lost"
+          % (name, mean, latency[ok // 2], p95, sent // ok, received // ok, lost))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host")
+    parser.add_argument("properties", nargs="+")
+    parser.add_argument("--device", type=int, default=0, help="index in configureddevices")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--binary-port", type=int, default=32228)
+    parser.add_argument("-n", type=int, default=200, help="poll cycles per mode")
+    parser.add_argument("--rate", type=float, default=0, help="poll cycles per second, 0 = back to back")
+    parser.add_argument("--connect", action="store_true", help="connect the device before polling")
+    args = parser.parse_args()
+
+    devices = configured_devices(args.host, args.port)
+    if args.device >= len(devices):
+        sys.exit("no device %d, server has %d" % (args.device, len(devices)))
+    device = devices[args.device]
+    prefix = "/api/v1/%s/%d/" % (device["DeviceType"].lower(), device["DeviceNumber"])
+    print("%s %s: %s" % (device["DeviceName"], prefix, ", ".join(args.properties)))
+
+    if args.connect:
+        data = urllib.parse.urlencode({"Connected": "True", "ClientID": 1}).encode()
+        urllib.request.urlopen(urllib.request.Request("http://%s:%d%sconnected" % (args.host, args.port, prefix), data, method="PUT")).read()
+
+    udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    udp.settimeout(0.5)
+    address = (args.host, args.binary_port)
+    names = args.properties
+    _, _, values = binary_request(udp, address, args.device, names)
+    print("values: " + ", ".join("%s=%s" % item for item in zip(names, values)))
+
+    def http_poll():
+        totals = [http_get(args.host, args.port, prefix + name + "?ClientID=1") for name in names]
+        return sum(t[0] for t in totals), sum(t[1] for t in totals)
+
+    def binary_poll():
+        totals = [binary_request(udp, address, args.device, [name]) for name in names]
+        return sum(t[0] for t in totals), sum(t[1] for t in totals)
+
+    def batch_poll():
+        out, back, _ = binary_request(udp, address, args.device, names)
+        return out, back
+
+    run("http", args.n, args.rate, http_poll)
+    run("binary", args.n, args.rate, binary_poll)
+    run("binary batched", args.n, args.rate, batch_poll)
+
+
+if __name__ == "__main__":
+    main()
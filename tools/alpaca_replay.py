@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Replay a request trace captured by AlpacaServer (see enableTrace()) and report per-route latency.
+
+    alpaca_replay.py trace.bin                             # recorded latency only
+    alpaca_replay.py http://<ip>/trace --target http://<ip>  # fetch trace and replay at original speed
+    alpaca_replay.py trace.bin --target http://<ip> --speed 10  # 10x faster, 0 = back to back
+"""
+import argparse
+import struct
+import sys
+import time
+import urllib.parse
+import urllib.request
+
+RECORD = struct.Struct("<IIIIHB45s")
+TRUNCATED = 0x80
+METHODS = {"G": "GET", "P": "PUT", "O": "POST"}
+
+
+def load(source):
+    if source.startswith("http://") or source.startswith("https://"):
+        with urllib.request.urlopen(source) as response:
+            data = response.read()
+    else:
+        with open(source, "rb") as f:
+            data = f.read()
+    magic, version, n_routes, count = struct.unpack_from("<4sHHI", data, 0)
+    if magic != b"ATRC" or version not in (1, 2):
+        sys.exit("not an alpaca trace (version 1 or 2)")
+    offset = 12
+    routes = {}
+    for _ in range(n_routes):
+        route_id, method, length = struct.unpack_from("<IcB", data, offset)
+        offset += 6
+        url = data[offset:offset + length].decode()
+        offset += length
+        routes[route_id] = (method.decode(), url)
+    records = []
+    for _ in range(count):
+        start, duration, route_id, client, size, params_len, params = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+        method, url = routes.get(route_id, ("G", "?%08x" % route_id))
+        records.append({"start": start, "duration": duration, "method": method, "url": url,
+                        "client": "%d.%d.%d.%d" % tuple(client.to_bytes(4, "little")),
+                        "size": size, "params": params[:params_len & ~TRUNCATED].decode(errors="replace"),
+                        "truncated": version >= 2 and bool(params_len & TRUNCATED)})
+    return records
+
+
+def replay(records, target, speed):
+    base = records[0]["start"] if records else 0
+    t0 = time.monotonic()
+    for record in records:
+        # the parameters are incomplete, sending them would replay a different request
+        if record["truncated"]:
+            continue
+        if speed > 0:
+            delay = ((record["start"] - base) & 0xFFFFFFFF) / 1e6 / speed - (time.monotonic() - t0)
+            if delay > 0:
+                time.sleep(delay)
+        method = METHODS[record["method"]]
+        url = target.rstrip("/") + record["url"]
+        body = None
+        if method == "GET" and record["params"]:
+            url += "?" + record["params"]
+        elif record["params"]:
+            body = record["params"].encode()
+        request = urllib.request.Request(url, data=body, method=method)
+        if body is not None:
+            request.add_header("Content-Type", "application/x-www-form-urlencoded")
+        start = time.monotonic()
+        try:
+            with urllib.request.urlopen(request, timeout=10) as response:
+                response.read()
+        except Exception as error:
+            record["error"] = str(error)
+        record["replay"] = int((time.monotonic() - start) * 1e6)
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p / 100 * len(values)))] if values else 0
+
+
+def report(records):
+    routes = {}
+    for record in records:
+        routes.setdefault((record["method"], record["url"]), []).append(record)
+    print("%-56s %6s %10s %10s %10s %10s %10s %6s %6s" % ("route", "n", "rec p50", "rec p95", "rep p50", "rep p95", "rep max", "errors", "trunc"))
+    for (method, url), items in sorted(routes.items(), key=lambda item: -len(item[1])):
+        recorded = [r["duration"] for r in items]
+        replayed = [r["replay"] for r in items if "replay" in r]
+        errors = sum(1 for r in items if "error" in r)
+        truncated = sum(1 for r in items if r["truncated"])
+        print("%-56s %6d %10d %10d %10s %10s %10s %6d %6d" % (
+            METHODS[method] + " " + url, len(items), percentile(recorded, 50), percentile(recorded, 95),
+            percentile(replayed, 50) if replayed else "-", percentile(replayed, 95) if replayed else "-",
+            max(replayed) if replayed else "-", errors, truncated))
+    print("times in microseconds, recorded = handler time on the device, replay = round trip from this host")
+    print("trunc = records whose parameters did not fit the trace, these are not replayed")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="trace file or http://<ip>/trace")
+    parser.add_argument("--target", help="server to replay against, e.g. http://192.168.1.20")
+    parser.add_argument("--speed", type=float, default=1.0, help="time scale, 1 = original, 0 = back to back")
+    args = parser.parse_args()
+    records = load(args.trace)
+    if args.target:
+        replay(records, args.target, args.speed)
+    report(records)
+
+
+if __name__ == "__main__":
+    main()